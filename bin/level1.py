@@ -29,13 +29,13 @@ t3.x = 11 * PPM
 t3.y = 2 * PPM
 app.AddBox2D(gameOverEntity, t3.x, t3.y, 1, 1, True, True)
 app.AddSprite(gameOverEntity, "../assets/flag.bmp", 1, 1)
-box2d = scene.GetBox2DColliderComponent(gameOverEntity)
+callback = scene.GetMutCollisionCallbackComponent(gameOverEntity)
 def on_collision_enter():
     print("YOU WIN! Load next level")
     time.sleep(2)  # Delay for 2 seconds
     setattr(app, "m_isRunning", False)
 
-box2d.onCollisionEnter = on_collision_enter
+callback.onCollisionEnter = on_collision_enter
 
 
 while app.m_isRunning:
@@ -11,6 +11,9 @@
 #include "RenderingSystem.hpp"
 #include "PhysicsSystem.hpp"
 #include "InputSystem.hpp"
+#include "JobSystem.hpp"
+#include "SystemScheduler.hpp"
+#include "PhysicsThread.hpp"
 
 /**
  * @brief The main application class
@@ -30,6 +33,8 @@ public:
           m_scene(),
           m_sceneView(m_scene),
           m_physicsWorld(new b2World(gravity)),
+          m_physics(m_physicsWorld),
+          m_scheduler(&m_jobSystem),
           m_renderingSystem(&m_scene, m_board),
           m_physicsSystem(&m_scene, m_board),
           m_inputSystem(&m_scene, m_renderingSystem.GetSDLLayer(), m_board, m_renderingSystem.GetImGuiLayer())
@@ -37,6 +42,21 @@ public:
         // Initialize Render Variables
         m_scene.m_showGrid = renderDebug;
         m_scene.m_showColliders = renderDebug;
+        m_scene.jobSystem = &m_jobSystem;
+        m_scene.physics = &m_physics;
+        m_physicsSystem.Register(m_scheduler);
+
+        // Bodies of removed colliders and destroyed entities leave the world at the next sync point
+        PhysicsThread *physics = &m_physics;
+        m_scene.OnRemove<Box2DColliderComponent>([physics](Scene &, const std::vector<EntityID> &, const std::vector<Box2DColliderComponent> &colliders)
+                                                 {
+            for (const Box2DColliderComponent &collider : colliders)
+            {
+                if (collider.body)
+                {
+                    physics->DestroyBody(collider.body);
+                }
+            } });
     }
 
     /**
@@ -52,14 +72,14 @@ public:
      * @return true if application should quit
      * @return false if application should continue
      */
-    bool Input(float deltaTime) const;
+    bool Input(float deltaTime);
 
     /**
      * @brief Update the application state
      *
      * @param deltaTime time since last frame
      */
-    void Update(float deltaTime) const;
+    void Update(float deltaTime);
 
     /**
      * @brief Render the application
@@ -104,6 +124,12 @@ public:
     void
     ImportSpritesheetLevel(const std::string levelPath, const std::string spritesheetPath);
 
+    /**
+     * @brief Destroy every entity and body of the current level so another one can be loaded
+     *
+     */
+    void UnloadLevel();
+
     const Scene &GetScene() { return m_scene; }
 
     bool m_isRunning = true;
@@ -115,9 +141,14 @@ private:
 
     const SceneView<> m_sceneView;
     b2World *const m_physicsWorld;
+    PhysicsThread m_physics; // Steps m_physicsWorld while the rest of the frame runs
+
+    // Worker threads and the systems they run every update
+    JobSystem m_jobSystem;
+    SystemScheduler m_scheduler;
 
     // Systems
     RenderingSystem m_renderingSystem;
     const PhysicsSystem m_physicsSystem;
-    const InputSystem m_inputSystem;
+    InputSystem m_inputSystem;
 };
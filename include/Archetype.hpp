@@ -0,0 +1,374 @@
+#pragma once
+
+#include <vector>
+#include <new>
+#include <algorithm>
+#include "ComponentInfo.hpp"
+#include "Constants.hpp"
+
+/**
+ * @brief Storage for every entity sharing the exact same component mask
+ *
+ * Rows are packed into fixed size chunks. Each chunk is laid out as structure of arrays: the
+ * owning entity indices first, followed by one contiguous column per component.
+ */
+struct Archetype
+{
+    /**
+     * @brief Construct a new Archetype object and compute its chunk layout
+     *
+     * @param archetypeMask Components stored by this archetype
+     * @param infos Description of every registered component, indexed by component id
+     */
+    Archetype(const ComponentMask &archetypeMask, const std::vector<ComponentInfo> &infos)
+        : mask(archetypeMask)
+    {
+        size_t rowSize = sizeof(EntityIndex);
+        for (size_t componentId = 0; componentId < infos.size(); componentId++)
+        {
+            if (mask.test(componentId))
+            {
+                componentIds.push_back(int(componentId));
+                columnInfos.push_back(infos[componentId]);
+                rowSize += infos[componentId].size;
+            }
+        }
+
+        // Shrink the row count until every aligned column fits in a chunk. Keeping it a multiple of
+        // the ticks per cache line makes the tick rows of every chunk start on a line too
+        const size_t ticksPerLine = CACHE_LINE_SIZE / sizeof(ComponentTicks);
+        chunkCapacity = ARCHETYPE_CHUNK_SIZE / rowSize;
+        while (chunkCapacity > 1 && Layout(chunkCapacity) > ARCHETYPE_CHUNK_SIZE)
+        {
+            chunkCapacity--;
+        }
+        if (chunkCapacity > ticksPerLine)
+        {
+            chunkCapacity -= chunkCapacity % ticksPerLine;
+        }
+        if (chunkCapacity == 0)
+        {
+            chunkCapacity = 1;
+        }
+        chunkSize = std::max(ARCHETYPE_CHUNK_SIZE, Layout(chunkCapacity));
+
+        columnTicks.resize(componentIds.size());
+        columnOf.resize(infos.size(), -1);
+        for (size_t column = 0; column < componentIds.size(); column++)
+        {
+            columnOf[componentIds[column]] = int(column);
+        }
+    }
+
+    /**
+     * @brief Destroy the Archetype object, its remaining components and its chunks
+     *
+     */
+    ~Archetype()
+    {
+        for (size_t row = 0; row < count; row++)
+        {
+            DestroyRow(row);
+        }
+        for (char *chunk : chunks)
+        {
+            ::operator delete(chunk, std::align_val_t(CACHE_LINE_SIZE));
+        }
+    }
+
+    Archetype(const Archetype &) = delete;
+    Archetype &operator=(const Archetype &) = delete;
+
+    /**
+     * @brief Get the column of a component in this archetype
+     *
+     * @param componentId Component id
+     * @return int Column index, -1 if the archetype does not store the component
+     */
+    inline int ColumnOf(int componentId) const
+    {
+        return size_t(componentId) < columnOf.size() ? columnOf[componentId] : -1;
+    }
+
+    /**
+     * @brief Get the entity indices column of a chunk
+     *
+     * @param chunk Chunk index
+     * @return EntityIndex*
+     */
+    inline EntityIndex *Entities(size_t chunk) const
+    {
+        return reinterpret_cast<EntityIndex *>(chunks[chunk]);
+    }
+
+    /**
+     * @brief Get the start of a component column in a chunk
+     *
+     * @param chunk Chunk index
+     * @param column Column index
+     * @return void*
+     */
+    inline void *Column(size_t chunk, int column) const
+    {
+        return chunks[chunk] + columnOffsets[column];
+    }
+
+    /**
+     * @brief Get the component stored in a column of a row
+     *
+     * @param row Row index
+     * @param column Column index
+     * @return void*
+     */
+    inline void *Get(size_t row, int column) const
+    {
+        return static_cast<char *>(Column(row / chunkCapacity, column)) + (row % chunkCapacity) * columnInfos[column].size;
+    }
+
+    /**
+     * @brief Get the change ticks of the component stored in a column of a row
+     *
+     * @param row Row index
+     * @param column Column index
+     * @return ComponentTicks&
+     */
+    inline ComponentTicks &Ticks(size_t row, int column)
+    {
+        return columnTicks[column][row];
+    }
+
+    /**
+     * @brief Get the entity index stored in a row
+     *
+     * @param row Row index
+     * @return EntityIndex
+     */
+    inline EntityIndex EntityAt(size_t row) const
+    {
+        return Entities(row / chunkCapacity)[row % chunkCapacity];
+    }
+
+    /**
+     * @brief Append a row for an entity, allocating a new chunk if needed
+     *
+     * The component columns of the new row are left uninitialized.
+     *
+     * @param index Entity index
+     * @return size_t The new row
+     */
+    size_t PushRow(EntityIndex index)
+    {
+        if (count == chunks.size() * chunkCapacity)
+        {
+            chunks.push_back(static_cast<char *>(::operator new(chunkSize, std::align_val_t(CACHE_LINE_SIZE))));
+        }
+        size_t row = count++;
+        Entities(row / chunkCapacity)[row % chunkCapacity] = index;
+        for (TickVector &ticks : columnTicks)
+        {
+            ticks.emplace_back();
+        }
+        return row;
+    }
+
+    /**
+     * @brief Append rows for a run of consecutive entity indices, allocating chunks once
+     *
+     * The component columns of the new rows are left uninitialized.
+     *
+     * @param first First entity index
+     * @param rows Number of rows
+     * @param stamp Change ticks of every component of the new rows
+     * @return size_t The first new row
+     */
+    size_t PushRows(EntityIndex first, size_t rows, ComponentTicks stamp)
+    {
+        size_t start = count;
+        count += rows;
+        while (chunks.size() * chunkCapacity < count)
+        {
+            chunks.push_back(static_cast<char *>(::operator new(chunkSize, std::align_val_t(CACHE_LINE_SIZE))));
+        }
+        for (size_t row = start; row < count; row++)
+        {
+            Entities(row / chunkCapacity)[row % chunkCapacity] = first + EntityIndex(row - start);
+        }
+        for (TickVector &ticks : columnTicks)
+        {
+            ticks.resize(count, stamp);
+        }
+        return start;
+    }
+
+    /**
+     * @brief Create an archetype with the same layout holding copies of every row
+     *
+     * The archetype graph is not copied.
+     *
+     * @param infos Description of every registered component, indexed by component id
+     * @return Archetype* Owned by the caller
+     */
+    Archetype *Clone(const std::vector<ComponentInfo> &infos) const
+    {
+        Archetype *pClone = new Archetype(mask, infos);
+        pClone->columnTicks = columnTicks;
+        pClone->count = count;
+        for (size_t chunk = 0; chunk < chunks.size(); chunk++)
+        {
+            pClone->chunks.push_back(static_cast<char *>(::operator new(chunkSize, std::align_val_t(CACHE_LINE_SIZE))));
+            size_t rows = count > chunk * chunkCapacity ? std::min(chunkCapacity, count - chunk * chunkCapacity) : 0;
+            std::copy(Entities(chunk), Entities(chunk) + rows, pClone->Entities(chunk));
+            for (size_t column = 0; column < columnInfos.size(); column++)
+            {
+                const ComponentInfo &info = columnInfos[column];
+                char *pSource = static_cast<char *>(Column(chunk, int(column)));
+                char *pTarget = static_cast<char *>(pClone->Column(chunk, int(column)));
+                if (info.trivial)
+                {
+                    std::memcpy(pTarget, pSource, rows * info.size);
+                    continue;
+                }
+                for (size_t slot = 0; slot < rows; slot++)
+                {
+                    info.copy(pTarget + slot * info.size, pSource + slot * info.size);
+                }
+            }
+        }
+        return pClone;
+    }
+
+    /**
+     * @brief Reorder the rows so row i receives the row that was at order[i]
+     *
+     * @param order Source row of every destination row
+     */
+    void PermuteRows(const std::vector<uint32_t> &order)
+    {
+        for (size_t column = 0; column < columnInfos.size(); column++)
+        {
+            PermuteComponents(columnInfos[column], order, [this, column](size_t row)
+                              { return Get(row, int(column)); });
+            PermuteValues(columnTicks[column], order);
+        }
+
+        std::vector<EntityIndex> owners;
+        owners.reserve(count);
+        for (uint32_t source : order)
+        {
+            owners.push_back(EntityAt(source));
+        }
+        for (size_t row = 0; row < count; row++)
+        {
+            Entities(row / chunkCapacity)[row % chunkCapacity] = owners[row];
+        }
+    }
+
+    /**
+     * @brief Run the destructor of every component in a row
+     *
+     * @param row Row index
+     */
+    void DestroyRow(size_t row)
+    {
+        for (size_t column = 0; column < columnInfos.size(); column++)
+        {
+            if (columnInfos[column].destroy)
+            {
+                columnInfos[column].destroy(Get(row, int(column)));
+            }
+        }
+    }
+
+    /**
+     * @brief Destroy every row, keeping the chunks for the rows added next
+     *
+     */
+    void Clear()
+    {
+        for (size_t row = 0; row < count; row++)
+        {
+            DestroyRow(row);
+        }
+        for (TickVector &ticks : columnTicks)
+        {
+            ticks.clear();
+        }
+        count = 0;
+    }
+
+    /**
+     * @brief Remove a row by moving the last row into it
+     *
+     * Components left in the removed row must already have been relocated or destroyed.
+     *
+     * @param row Row to remove
+     * @return EntityIndex The entity now stored at row, -1 if no entity was moved
+     */
+    EntityIndex RemoveRow(size_t row)
+    {
+        size_t last = --count;
+        EntityIndex moved = EntityIndex(-1);
+        if (row != last)
+        {
+            for (size_t column = 0; column < columnInfos.size(); column++)
+            {
+                columnInfos[column].relocate(Get(row, int(column)), Get(last, int(column)));
+                columnTicks[column][row] = columnTicks[column][last];
+            }
+            moved = EntityAt(last);
+            Entities(row / chunkCapacity)[row % chunkCapacity] = moved;
+        }
+        for (TickVector &ticks : columnTicks)
+        {
+            ticks.pop_back();
+        }
+
+        // Release trailing chunks, keeping one spare so a row at a chunk boundary does not thrash
+        size_t used = (count + chunkCapacity - 1) / chunkCapacity;
+        while (chunks.size() > used + 1)
+        {
+            ::operator delete(chunks.back(), std::align_val_t(CACHE_LINE_SIZE));
+            chunks.pop_back();
+        }
+        return moved;
+    }
+
+    ComponentMask mask;
+    std::vector<int> componentIds;          // Component id of each column
+    std::vector<ComponentInfo> columnInfos; // Type description of each column
+    std::vector<size_t> columnOffsets;      // Byte offset of each column inside a chunk
+    std::vector<int> columnOf;              // Column of each component id, -1 if absent
+    std::vector<TickVector> columnTicks;    // Change ticks of each column, indexed by row
+    size_t chunkCapacity{0};                // Rows per chunk
+    size_t chunkSize{0};                    // Bytes per chunk
+    std::vector<char *> chunks;
+    size_t count{0};
+
+    // Archetype graph, indexed by component id
+    std::vector<Archetype *> addEdges;
+    std::vector<Archetype *> removeEdges;
+
+private:
+    /**
+     * @brief Compute the column offsets for a row capacity
+     *
+     * Every column starts on a cache line, so parallel jobs cutting a chunk at multiples of 64 rows
+     * never write the same line.
+     *
+     * @param capacity Rows per chunk
+     * @return size_t Bytes used by a chunk
+     */
+    size_t Layout(size_t capacity)
+    {
+        columnOffsets.clear();
+        size_t offset = sizeof(EntityIndex) * capacity;
+        for (const ComponentInfo &info : columnInfos)
+        {
+            size_t alignment = std::max(info.alignment, CACHE_LINE_SIZE);
+            offset = (offset + alignment - 1) / alignment * alignment;
+            columnOffsets.push_back(offset);
+            offset += info.size * capacity;
+        }
+        return offset;
+    }
+};
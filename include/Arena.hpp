@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Constants.hpp"
+
+/**
+ * @brief Bump allocator for data living as long as a level
+ *
+ * Allocations are carved out of fixed size blocks and never freed one by one. Objects with a
+ * destructor are registered when created with New and destroyed in reverse order by Reset, which
+ * then rewinds to the first block. The blocks are kept, so loading the next level allocates from
+ * memory that is already mapped and warm.
+ */
+struct MonotonicArena
+{
+    MonotonicArena() = default;
+
+    /**
+     * @brief Destroy the Monotonic Arena object, its remaining objects and its blocks
+     *
+     */
+    ~MonotonicArena()
+    {
+        Reset();
+        for (char *pBlock : blocks)
+        {
+            ::operator delete(pBlock, std::align_val_t(CACHE_LINE_SIZE));
+        }
+    }
+
+    MonotonicArena(const MonotonicArena &) = delete;
+    MonotonicArena &operator=(const MonotonicArena &) = delete;
+
+    /**
+     * @brief Allocate memory valid until the next Reset
+     *
+     * Requests larger than a block get a block of their own, released by Reset.
+     *
+     * @param size Bytes
+     * @param alignment Alignment in bytes, at most CACHE_LINE_SIZE
+     * @return void*
+     */
+    void *Allocate(size_t size, size_t alignment)
+    {
+        if (size > ARENA_BLOCK_SIZE)
+        {
+            char *pLarge = static_cast<char *>(::operator new(size, std::align_val_t(CACHE_LINE_SIZE)));
+            largeBlocks.push_back(pLarge);
+            return pLarge;
+        }
+
+        offset = (offset + alignment - 1) / alignment * alignment;
+        if (blocks.empty() || offset + size > ARENA_BLOCK_SIZE)
+        {
+            if (!blocks.empty())
+            {
+                block++;
+            }
+            if (block == blocks.size())
+            {
+                blocks.push_back(static_cast<char *>(::operator new(ARENA_BLOCK_SIZE, std::align_val_t(CACHE_LINE_SIZE))));
+            }
+            offset = 0;
+        }
+        void *pMemory = blocks[block] + offset;
+        offset += size;
+        return pMemory;
+    }
+
+    /**
+     * @brief Construct an object in the arena, its destructor runs on Reset
+     *
+     * @tparam T Object type
+     * @tparam Args Constructor arguments
+     * @param args Constructor arguments
+     * @return T*
+     */
+    template <typename T, typename... Args>
+    T *New(Args &&...args)
+    {
+        static_assert(alignof(T) <= CACHE_LINE_SIZE, "Arena objects must fit the block alignment");
+        T *pObject = new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        if constexpr (!std::is_trivially_destructible<T>::value)
+        {
+            finalizers.push_back({pObject, [](void *pMemory)
+                                  { static_cast<T *>(pMemory)->~T(); }});
+        }
+        return pObject;
+    }
+
+    /**
+     * @brief Destroy every object created since the last reset and rewind to the first block
+     *
+     */
+    void Reset()
+    {
+        for (auto it = finalizers.rbegin(); it != finalizers.rend(); ++it)
+        {
+            it->destroy(it->pObject);
+        }
+        finalizers.clear();
+        for (char *pLarge : largeBlocks)
+        {
+            ::operator delete(pLarge, std::align_val_t(CACHE_LINE_SIZE));
+        }
+        largeBlocks.clear();
+        block = 0;
+        offset = 0;
+    }
+
+    /**
+     * @brief Bytes reserved by the arena, kept across resets
+     *
+     * @return size_t
+     */
+    size_t Capacity() const
+    {
+        return blocks.size() * ARENA_BLOCK_SIZE;
+    }
+
+private:
+    /**
+     * @brief Destructor call of an object created with New
+     *
+     */
+    struct Finalizer
+    {
+        void *pObject;
+        void (*destroy)(void *);
+    };
+
+    std::vector<char *> blocks;
+    std::vector<char *> largeBlocks; // Oversized allocations, freed on reset
+    std::vector<Finalizer> finalizers;
+    size_t block{0};  // Block currently allocated from
+    size_t offset{0}; // Next free byte in the current block
+};
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <new>
+#include "ComponentInfo.hpp"
+#include "ComponentRegistry.hpp"
+#include "Constants.hpp"
+
+/**
+ * @brief Structural change recorded by a CommandBuffer
+ *
+ */
+enum class CommandType : uint8_t
+{
+    SPAWN,
+    ASSIGN,
+    REMOVE,
+    DESTROY
+};
+
+/**
+ * @brief A recorded structural change
+ *
+ */
+struct Command
+{
+    CommandType type;
+    int componentId; // Component assigned or removed, -1 for spawn and destroy
+    EntityID entity;
+    void *payload; // Staged component of an assign, null once it has been moved into the scene
+};
+
+// Index of the entity ids returned by CommandBuffer::Spawn until the buffer is flushed
+const EntityIndex PENDING_ENTITY_INDEX = EntityIndex(-2);
+
+/**
+ * @brief Records spawn/assign/remove/destroy operations to apply to a Scene later
+ *
+ * Recording never touches the scene, so it is safe inside a view loop, from collision callbacks
+ * and, with one buffer per thread, from worker threads. Scene::FlushCommands applies every buffer
+ * in one batched pass at a sync point. Assigned components are constructed in the buffer's own
+ * block arena and relocated into the scene on flush.
+ */
+struct CommandBuffer
+{
+    CommandBuffer() = default;
+
+    /**
+     * @brief Destroy the Command Buffer object, discarding unflushed commands
+     *
+     */
+    ~CommandBuffer()
+    {
+        Clear();
+        for (char *block : blocks)
+        {
+            ::operator delete(block, std::align_val_t(CACHE_LINE_SIZE));
+        }
+    }
+
+    CommandBuffer(const CommandBuffer &) = delete;
+    CommandBuffer &operator=(const CommandBuffer &) = delete;
+
+    /**
+     * @brief Record the creation of an entity
+     *
+     * @return EntityID Pending id, only valid for commands of this buffer until it is flushed
+     */
+    EntityID Spawn()
+    {
+        EntityID id = ((EntityID)PENDING_ENTITY_INDEX << 32) | EntityID(pendingCount++);
+        commands.push_back({CommandType::SPAWN, -1, id, nullptr});
+        return id;
+    }
+
+    /**
+     * @brief Record the assignment of a component
+     *
+     * @tparam T Component
+     * @param id Entity ID or pending id from Spawn
+     * @return T* Staged component to fill in, moved into the scene on flush
+     */
+    template <typename T>
+    T *Assign(EntityID id)
+    {
+        static_assert(sizeof(T) <= COMMAND_BLOCK_SIZE, "Component too large for a command block");
+        T *pComponent = new (Allocate(sizeof(T), alignof(T))) T();
+        commands.push_back({CommandType::ASSIGN, ComponentTraits<T>::ID, id, pComponent});
+        return pComponent;
+    }
+
+    /**
+     * @brief Record the removal of a component
+     *
+     * @tparam T Component
+     * @param id Entity ID or pending id from Spawn
+     */
+    template <typename T>
+    void Remove(EntityID id)
+    {
+        commands.push_back({CommandType::REMOVE, ComponentTraits<T>::ID, id, nullptr});
+    }
+
+    /**
+     * @brief Record the destruction of an entity
+     *
+     * @param id Entity ID or pending id from Spawn
+     */
+    void Destroy(EntityID id)
+    {
+        commands.push_back({CommandType::DESTROY, -1, id, nullptr});
+    }
+
+    /**
+     * @brief Check if an id was returned by Spawn and not flushed yet
+     *
+     * @param id Entity ID
+     * @return true if the id is pending
+     */
+    static bool IsPending(EntityID id)
+    {
+        return (id >> 32) == PENDING_ENTITY_INDEX;
+    }
+
+    /**
+     * @brief Check if the buffer has no recorded commands
+     *
+     * @return true if there is nothing to flush
+     */
+    bool Empty() const
+    {
+        return commands.empty();
+    }
+
+    /**
+     * @brief Drop every command, destroying staged components that were not moved into a scene
+     *
+     * The arena blocks are kept for the next frame.
+     */
+    void Clear()
+    {
+        for (Command &command : commands)
+        {
+            if (command.payload && RegisteredComponents()[command.componentId].destroy)
+            {
+                RegisteredComponents()[command.componentId].destroy(command.payload);
+            }
+        }
+        commands.clear();
+        pendingCount = 0;
+        block = 0;
+        offset = 0;
+    }
+
+    std::vector<Command> commands;
+    uint32_t pendingCount{0}; // Entities spawned since the last flush
+
+private:
+    /**
+     * @brief Allocate memory for a staged component from the block arena
+     *
+     * Blocks never move, so staged components stay valid until the buffer is cleared.
+     *
+     * @param size Bytes
+     * @param alignment Alignment in bytes
+     * @return void*
+     */
+    void *Allocate(size_t size, size_t alignment)
+    {
+        offset = (offset + alignment - 1) / alignment * alignment;
+        if (blocks.empty() || offset + size > COMMAND_BLOCK_SIZE)
+        {
+            if (!blocks.empty())
+            {
+                block++;
+            }
+            if (block == blocks.size())
+            {
+                blocks.push_back(static_cast<char *>(::operator new(COMMAND_BLOCK_SIZE, std::align_val_t(CACHE_LINE_SIZE))));
+            }
+            offset = 0;
+        }
+        void *pMemory = blocks[block] + offset;
+        offset += size;
+        return pMemory;
+    }
+
+    std::vector<char *> blocks;
+    size_t block{0};  // Block currently allocated from
+    size_t offset{0}; // Next free byte in the current block
+};
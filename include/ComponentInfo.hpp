@@ -0,0 +1,251 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <vector>
+#include "Constants.hpp"
+
+/**
+ * @brief Default construct a component in uninitialized memory
+ *
+ */
+typedef void (*ConstructFn)(void *dst);
+
+/**
+ * @brief Run the destructor of a component, leaving its memory uninitialized
+ *
+ */
+typedef void (*DestroyFn)(void *src);
+
+/**
+ * @brief Move a component from src into uninitialized memory at dst and destroy src
+ *
+ */
+typedef void (*RelocateFn)(void *dst, void *src);
+
+/**
+ * @brief Copy construct a component from src into uninitialized memory at dst
+ *
+ */
+typedef void (*CopyFn)(void *dst, const void *src);
+
+/**
+ * @brief Default construct a component of type T
+ *
+ * @tparam T Component
+ * @param dst Uninitialized destination memory
+ */
+template <typename T>
+void ConstructComponent(void *dst)
+{
+    new (dst) T();
+}
+
+/**
+ * @brief Destroy a component of type T
+ *
+ * @tparam T Component
+ * @param src Component to destroy
+ */
+template <typename T>
+void DestroyComponent(void *src)
+{
+    static_cast<T *>(src)->~T();
+}
+
+/**
+ * @brief Relocate a component of type T
+ *
+ * @tparam T Component
+ * @param dst Uninitialized destination memory
+ * @param src Component to move from, destroyed afterwards
+ */
+template <typename T>
+void RelocateComponent(void *dst, void *src)
+{
+    T *pSource = static_cast<T *>(src);
+    new (dst) T(std::move(*pSource));
+    pSource->~T();
+}
+
+/**
+ * @brief Copy a component of type T
+ *
+ * @tparam T Component
+ * @param dst Uninitialized destination memory
+ * @param src Component to copy from
+ */
+template <typename T>
+void CopyComponent(void *dst, const void *src)
+{
+    new (dst) T(*static_cast<const T *>(src));
+}
+
+/**
+ * @brief Scene ticks at which a component was assigned and last changed
+ *
+ */
+struct ComponentTicks
+{
+    Tick added{0};
+    Tick changed{0};
+};
+
+/**
+ * @brief Allocator placing the elements of a vector on a cache line boundary
+ *
+ * @tparam T Element
+ */
+template <typename T>
+struct CacheLineAllocator
+{
+    typedef T value_type;
+
+    CacheLineAllocator() = default;
+
+    template <typename U>
+    CacheLineAllocator(const CacheLineAllocator<U> &) {}
+
+    T *allocate(size_t count)
+    {
+        return static_cast<T *>(::operator new(count * sizeof(T), std::align_val_t(CACHE_LINE_SIZE)));
+    }
+
+    void deallocate(T *pElements, size_t)
+    {
+        ::operator delete(pElements, std::align_val_t(CACHE_LINE_SIZE));
+    }
+
+    template <typename U>
+    bool operator==(const CacheLineAllocator<U> &) const
+    {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const CacheLineAllocator<U> &) const
+    {
+        return false;
+    }
+};
+
+// Change ticks indexed like the components they describe, aligned so the slices given to parallel jobs start on a cache line
+typedef std::vector<ComponentTicks, CacheLineAllocator<ComponentTicks>> TickVector;
+
+/**
+ * @brief Type erased description and lifecycle table of a component type used by the storage backends
+ *
+ * destroy is null for trivially destructible types, so bulk operations can skip them entirely. copy
+ * is null for types that cannot be copied, and trivial types are copied with memcpy.
+ */
+struct ComponentInfo
+{
+    size_t size{0};
+    size_t alignment{1};
+    ConstructFn construct{nullptr};
+    DestroyFn destroy{nullptr};
+    RelocateFn relocate{nullptr};
+    CopyFn copy{nullptr};
+    bool trivial{false}; // Trivially copyable
+};
+
+/**
+ * @brief Fill a contiguous run of uninitialized components with copies of a prototype
+ *
+ * Trivially copyable components are written with memcpy, doubling the filled prefix each pass.
+ *
+ * @param info Component description, must be copyable
+ * @param dst First component of the run
+ * @param count Number of components
+ * @param prototype Component to copy
+ */
+inline void FillComponents(const ComponentInfo &info, void *dst, size_t count, const void *prototype)
+{
+    char *pOut = static_cast<char *>(dst);
+    if (count == 0)
+    {
+        return;
+    }
+
+    if (info.trivial)
+    {
+        std::memcpy(pOut, prototype, info.size);
+        for (size_t filled = 1; filled < count;)
+        {
+            size_t chunk = std::min(filled, count - filled);
+            std::memcpy(pOut + filled * info.size, pOut, chunk * info.size);
+            filled += chunk;
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            info.copy(pOut + i * info.size, prototype);
+        }
+    }
+}
+
+/**
+ * @brief Reorder components in place so the slot at position i receives the component that was at order[i]
+ *
+ * Follows the cycles of the permutation, so every component is relocated once plus once per cycle.
+ *
+ * @tparam SlotFn void *(size_t position)
+ * @param info Component description
+ * @param order Source position of every destination position
+ * @param slot Address of the component at a position
+ */
+template <typename SlotFn>
+void PermuteComponents(const ComponentInfo &info, const std::vector<uint32_t> &order, SlotFn slot)
+{
+    void *pScratch = ::operator new(info.size, std::align_val_t(std::max(info.alignment, alignof(std::max_align_t))));
+    std::vector<uint8_t> visited(order.size(), 0);
+    for (size_t start = 0; start < order.size(); start++)
+    {
+        if (visited[start] || order[start] == start)
+        {
+            continue;
+        }
+
+        info.relocate(pScratch, slot(start));
+        size_t current = start;
+        while (true)
+        {
+            visited[current] = 1;
+            size_t source = order[current];
+            if (source == start)
+            {
+                info.relocate(slot(current), pScratch);
+                break;
+            }
+            info.relocate(slot(current), slot(source));
+            current = source;
+        }
+    }
+    ::operator delete(pScratch, std::align_val_t(std::max(info.alignment, alignof(std::max_align_t))));
+}
+
+/**
+ * @brief Reorder a plain array so position i receives the element that was at order[i]
+ *
+ * @tparam T Element
+ * @tparam Allocator Allocator of the array
+ * @param values Array to reorder
+ * @param order Source position of every destination position
+ */
+template <typename T, typename Allocator>
+void PermuteValues(std::vector<T, Allocator> &values, const std::vector<uint32_t> &order)
+{
+    std::vector<T, Allocator> permuted;
+    permuted.reserve(values.size());
+    for (uint32_t source : order)
+    {
+        permuted.push_back(values[source]);
+    }
+    values.swap(permuted);
+}
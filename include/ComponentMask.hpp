@@ -0,0 +1,184 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+/**
+ * @brief Fixed size component bitmask stored in 64 bit words
+ *
+ * With up to 64 components the mask is a single word, so combining and comparing masks
+ * compiles down to one integer operation.
+ *
+ * @tparam Bits Number of components the mask can hold
+ */
+template <size_t Bits>
+struct BasicComponentMask
+{
+    static constexpr size_t WORDS = (Bits + 63) / 64;
+
+    /**
+     * @brief Set or clear the bit of a component
+     *
+     * @param pos Component id
+     * @param value New value of the bit
+     * @return BasicComponentMask&
+     */
+    BasicComponentMask &set(size_t pos, bool value = true)
+    {
+        if (value)
+        {
+            words[pos / 64] |= uint64_t(1) << (pos % 64);
+        }
+        else
+        {
+            words[pos / 64] &= ~(uint64_t(1) << (pos % 64));
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Clear the bit of a component
+     *
+     * @param pos Component id
+     * @return BasicComponentMask&
+     */
+    BasicComponentMask &reset(size_t pos)
+    {
+        return set(pos, false);
+    }
+
+    /**
+     * @brief Clear every bit
+     *
+     * @return BasicComponentMask&
+     */
+    BasicComponentMask &reset()
+    {
+        for (size_t i = 0; i < WORDS; i++)
+        {
+            words[i] = 0;
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Check the bit of a component
+     *
+     * @param pos Component id
+     * @return true if the bit is set
+     */
+    bool test(size_t pos) const
+    {
+        return (words[pos / 64] >> (pos % 64)) & 1;
+    }
+
+    /**
+     * @brief Check if no bit is set
+     *
+     * @return true if the mask is empty
+     */
+    bool none() const
+    {
+        for (size_t i = 0; i < WORDS; i++)
+        {
+            if (words[i] != 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Check if every bit of other is also set in this mask
+     *
+     * @param other Mask to test
+     * @return true if other is a subset of this mask
+     */
+    bool contains(const BasicComponentMask &other) const
+    {
+        for (size_t i = 0; i < WORDS; i++)
+        {
+            if ((words[i] & other.words[i]) != other.words[i])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Check if this mask and other have a bit in common
+     *
+     * @param other Mask to test
+     * @return true if any bit is set in both masks
+     */
+    bool intersects(const BasicComponentMask &other) const
+    {
+        for (size_t i = 0; i < WORDS; i++)
+        {
+            if ((words[i] & other.words[i]) != 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    BasicComponentMask operator&(const BasicComponentMask &other) const
+    {
+        BasicComponentMask result;
+        for (size_t i = 0; i < WORDS; i++)
+        {
+            result.words[i] = words[i] & other.words[i];
+        }
+        return result;
+    }
+
+    BasicComponentMask operator|(const BasicComponentMask &other) const
+    {
+        BasicComponentMask result;
+        for (size_t i = 0; i < WORDS; i++)
+        {
+            result.words[i] = words[i] | other.words[i];
+        }
+        return result;
+    }
+
+    bool operator==(const BasicComponentMask &other) const
+    {
+        for (size_t i = 0; i < WORDS; i++)
+        {
+            if (words[i] != other.words[i])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool operator!=(const BasicComponentMask &other) const
+    {
+        return !(*this == other);
+    }
+
+    uint64_t words[WORDS]{};
+};
+
+namespace std
+{
+    template <size_t Bits>
+    struct hash<BasicComponentMask<Bits>>
+    {
+        size_t operator()(const BasicComponentMask<Bits> &mask) const
+        {
+            size_t seed = 0;
+            for (size_t i = 0; i < BasicComponentMask<Bits>::WORDS; i++)
+            {
+                seed ^= std::hash<uint64_t>()(mask.words[i]) + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+            }
+            return seed;
+        }
+    };
+}
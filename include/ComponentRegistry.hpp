@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+#include "Components.hpp"
+#include "SharedComponent.hpp"
+#include "ComponentInfo.hpp"
+#include "Constants.hpp"
+
+/**
+ * @brief Compile time list of types
+ *
+ * @tparam Types
+ */
+template <typename... Types>
+struct TypeList
+{
+    static constexpr size_t SIZE = sizeof...(Types);
+};
+
+/**
+ * @brief Position of T in a TypeList, fails to compile if T is not in the list
+ *
+ * @tparam T Type to find
+ * @tparam List TypeList to search
+ */
+template <typename T, typename List>
+struct TypeIndex;
+
+template <typename T, typename... Rest>
+struct TypeIndex<T, TypeList<T, Rest...>>
+{
+    static constexpr size_t VALUE = 0;
+};
+
+template <typename T, typename First, typename... Rest>
+struct TypeIndex<T, TypeList<First, Rest...>>
+{
+    static constexpr size_t VALUE = 1 + TypeIndex<T, TypeList<Rest...>>::VALUE;
+};
+
+template <typename T>
+struct TypeIndex<T, TypeList<>>
+{
+    static_assert(!std::is_same<T, T>::value, "Component is not registered in ComponentRegistry");
+    static constexpr size_t VALUE = 0;
+};
+
+/**
+ * @brief Every component type the scene can store, new components must be added here
+ *
+ * The position in the list is the component id, so ids are dense and known at compile time.
+ * Components shared between entities are registered as their Shared<T> handle.
+ */
+typedef TypeList<
+    TransformComponent,
+    Shared<SpriteComponent>,
+    InputComponent,
+    SpriteSheetComponent,
+    Box2DColliderComponent,
+    GridSimulationComponent,
+    ChildTag,
+    TriggerTag,
+    LocalTransformComponent,
+    ParentComponent,
+    BoundsComponent,
+    Box2DBodyDescComponent,
+    CollisionCallbackComponent>
+    ComponentRegistry;
+
+// Number of registered component types
+constexpr size_t COMPONENT_COUNT = ComponentRegistry::SIZE;
+static_assert(COMPONENT_COUNT <= size_t(MAX_COMPONENTS), "Too many components for ComponentMask");
+
+/**
+ * @brief Compile time traits of a registered component
+ *
+ * @tparam T Component
+ */
+template <typename T>
+struct ComponentTraits
+{
+    static constexpr int ID = int(TypeIndex<T, ComponentRegistry>::VALUE);
+    static constexpr size_t SIZE = sizeof(T);
+    static constexpr size_t ALIGNMENT = alignof(T);
+};
+
+/**
+ * @brief Build the lifecycle table of a component
+ *
+ * @tparam T Component
+ * @return ComponentInfo
+ */
+template <typename T>
+ComponentInfo DescribeComponent()
+{
+    DestroyFn destroy = std::is_trivially_destructible<T>::value ? nullptr : &DestroyComponent<T>;
+    CopyFn copy = nullptr;
+    if constexpr (std::is_copy_constructible<T>::value)
+    {
+        copy = &CopyComponent<T>;
+    }
+    return {ComponentTraits<T>::SIZE, ComponentTraits<T>::ALIGNMENT, &ConstructComponent<T>, destroy, &RelocateComponent<T>, copy, std::is_trivially_copyable<T>::value};
+}
+
+/**
+ * @brief Describe every component of a TypeList, indexed by component id
+ *
+ * @tparam Types Components
+ * @return std::vector<ComponentInfo>
+ */
+template <typename... Types>
+std::vector<ComponentInfo> DescribeComponents(TypeList<Types...>)
+{
+    return {DescribeComponent<Types>()...};
+}
+
+/**
+ * @brief Lifecycle table of every registered component, indexed by component id
+ *
+ * @return const std::vector<ComponentInfo>&
+ */
+inline const std::vector<ComponentInfo> &RegisteredComponents()
+{
+    static const std::vector<ComponentInfo> s_infos = DescribeComponents(ComponentRegistry());
+    return s_infos;
+}
@@ -7,35 +7,122 @@
 #include <functional>
 #include <cmath>
 #include <random>
+#include "Constants.hpp"
 
 /**
  * @brief Transform Component
  *
+ * World position of the entity. For entities with a parent it is derived from the parent and the
+ * LocalTransformComponent by Scene::UpdateHierarchy.
  */
 struct TransformComponent
 {
     float x{0.0f};         // X position in pixels
     float y{0.0f};         // Y position in pixels
-    bool hasParent{false}; // Does this entity have a parent entity
+};
+
+/**
+ * @brief Position of an entity relative to its parent
+ *
+ */
+struct LocalTransformComponent
+{
+    float x{0.0f}; // X offset from the parent in pixels
+    float y{0.0f}; // Y offset from the parent in pixels
+};
+
+/**
+ * @brief Size of an entity from its TransformComponent position, used by the spatial index
+ *
+ */
+struct BoundsComponent
+{
+    float width{0.0f};  // Width in pixels
+    float height{0.0f}; // Height in pixels
+};
+
+/**
+ * @brief Parent of an entity, set through Scene::SetParent
+ *
+ */
+struct ParentComponent
+{
+    EntityID parent{EntityID(-1)};
+};
+
+/**
+ * @brief Tag for entities owned by a parent entity, hidden from the scene hierarchy
+ *
+ */
+struct ChildTag
+{
+};
+
+/**
+ * @brief Tag for colliders acting as triggers
+ *
+ */
+struct TriggerTag
+{
 };
 
 /**
  * @brief Box2D Collider Component
  *
+ * Only what the per frame physics loops read, so iterating colliders stays within one cache line
+ * per entity. The body is built from a Box2DBodyDescComponent by Scene::CreateBox2DBody.
  */
 struct Box2DColliderComponent
+{
+    b2Body *body{nullptr};
+    b2Vec2 position{0.0f, 0.0f};    // Body position in meters as of the last physics sync
+    b2Vec2 halfExtents{0.0f, 0.0f}; // Half width and height of the body's box in meters
+    bool isStatic{false};           // Static bodies never move, their position is not synced
+    bool isTrigger{false};
+};
+
+/**
+ * @brief Box2D Body Description Component
+ *
+ * Everything needed to create the body of a Box2DColliderComponent. Removed from the entity once
+ * the body exists.
+ */
+struct Box2DBodyDescComponent
 {
     b2BodyDef bodyDef;
     b2PolygonShape shape;
     b2FixtureDef fixtureDef;
-    b2Body *body;
-    bool isTrigger{false};
 
+    /**
+     * @brief Describe a box body
+     *
+     * @param isStatic Whether the body is static or dynamic
+     * @param x Center x in meters
+     * @param y Center y in meters
+     * @param width Width in meters
+     * @param height Height in meters
+     */
+    void SetBox(bool isStatic, float x, float y, float width, float height)
+    {
+        bodyDef.position.Set(x, y);
+        bodyDef.type = isStatic ? b2_staticBody : b2_dynamicBody; // Static body does not move, dynamic body can move and collide with others
+        shape.SetAsBox(width / 2, height / 2);                    // Set box shape (half-width, half-height)
+        fixtureDef.density = 1.0f;                                // Set density for dynamic behavior
+        fixtureDef.friction = 0.2f;                               // Set friction
+    }
+};
+
+/**
+ * @brief Collision Callback Component
+ *
+ */
+struct CollisionCallbackComponent
+{
     // Callback function for collision
     std::function<void()> onCollisionEnter;
 
     // Function to call the collision callback
-    void OnCollisionEnter()
+    void OnCollisionEnter() const
     {
         if (onCollisionEnter)
         {
@@ -47,15 +134,37 @@ struct Box2DColliderComponent
 /**
  * @brief Sprite Component
  *
+ * Shared between entities, which hold a Shared<SpriteComponent> handle to it.
  */
 struct SpriteComponent
 {
     std::string filePath;                 // Path to the sprite image file
-    float width;                          // Width of the sprite
-    float height;                         // Height of the sprite
+    float width{0.0f};                    // Width of the sprite
+    float height{0.0f};                   // Height of the sprite
     std::shared_ptr<SDL_Texture> texture; // The texture of the sprite
+
+    bool operator==(const SpriteComponent &other) const
+    {
+        return filePath == other.filePath && width == other.width && height == other.height && texture == other.texture;
+    }
 };
 
+namespace std
+{
+    template <>
+    struct hash<SpriteComponent>
+    {
+        size_t operator()(const SpriteComponent &sprite) const
+        {
+            size_t seed = std::hash<std::string>()(sprite.filePath);
+            seed ^= std::hash<SDL_Texture *>()(sprite.texture.get()) + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+            seed ^= std::hash<float>()(sprite.width) + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+            seed ^= std::hash<float>()(sprite.height) + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+            return seed;
+        }
+    };
+}
+
 /**
  * @brief Input Component
  *
@@ -95,6 +204,36 @@ struct GridSimulationComponent
     // Grid data
     std::vector<particle_t> *gridData = new std::vector<particle_t>(rows * cols);
 
+    GridSimulationComponent() = default;
+
+    // The grid owns its data, so moving hands it over instead of sharing it
+    GridSimulationComponent(GridSimulationComponent &&other) noexcept
+        : rows(other.rows), cols(other.cols), brushType(other.brushType), gridData(other.gridData)
+    {
+        other.gridData = nullptr;
+    }
+
+    GridSimulationComponent &operator=(GridSimulationComponent &&other) noexcept
+    {
+        std::swap(gridData, other.gridData);
+        rows = other.rows;
+        cols = other.cols;
+        brushType = other.brushType;
+        return *this;
+    }
+
+    // Copies get their own grid data
+    GridSimulationComponent(const GridSimulationComponent &other)
+        : rows(other.rows), cols(other.cols), brushType(other.brushType), gridData(other.gridData ? new std::vector<particle_t>(*other.gridData) : nullptr)
+    {
+    }
+
+    GridSimulationComponent &operator=(const GridSimulationComponent &other)
+    {
+        GridSimulationComponent copy(other);
+        return *this = std::move(copy);
+    }
+
     // Destructor
     ~GridSimulationComponent()
     {
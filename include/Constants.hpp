@@ -1,12 +1,30 @@
-#include <bitset>
+#pragma once
 
-const int MAX_COMPONENTS = 200;
-const int MAX_ENTITIES = 200;
+#include <cstddef>
+#include "ComponentMask.hpp"
 
-typedef std::bitset<MAX_COMPONENTS> ComponentMask;
+// Component ids a mask can hold, 64 keeps every mask in a single word
+const int MAX_COMPONENTS = 64;
+
+// Entity indices per page of a component pool's sparse index
+const size_t SPARSE_PAGE_SIZE = 4096;
+// Components per page of a component pool's dense storage
+const size_t COMPONENT_PAGE_SIZE = 1024;
+// Bytes per chunk of archetype storage
+const size_t ARCHETYPE_CHUNK_SIZE = 16 * 1024;
+const size_t CACHE_LINE_SIZE = 64;
+// Bytes per block of a command buffer's staging arena
+const size_t COMMAND_BLOCK_SIZE = 16 * 1024;
+// Bytes per block of a scene's level arena
+const size_t ARENA_BLOCK_SIZE = 64 * 1024;
+// Entities per job of SceneView::par_each when no grain is given
+const size_t PAR_EACH_GRAIN = 1024;
+// Input events queued between the window thread and the simulation, a power of two
+const size_t INPUT_RING_SIZE = 1024;
+
+typedef BasicComponentMask<MAX_COMPONENTS> ComponentMask;
 
 typedef unsigned long long EntityID;
 typedef unsigned int EntityIndex;
 typedef unsigned int EntityVersion;
-
-extern int s_componentCounter;
+typedef unsigned int Tick;
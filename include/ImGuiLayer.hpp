@@ -58,6 +58,7 @@ private:
     SDL_Renderer *const m_renderer;
     SDL_Window *const m_window;
     Board *const m_board;
+    std::unordered_map<EntityID, std::vector<EntityID>> m_children; // Children of each parent, rebuilt every frame
 
     /**
      * @brief Render all entites in the scene
@@ -66,7 +67,7 @@ private:
     void DisplaySceneHierarchy();
 
     /**
-     * @brief Render the components of the selected entity
+     * @brief Render an entity of the hierarchy and, indented below it, its children
      *
      */
     void DisplayEntity(const EntityID &entityID);
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <atomic>
+#include <cstdint>
+#include "Constants.hpp"
+
+/**
+ * @brief Lock free ring buffer with one producer thread and one consumer thread
+ *
+ * The producer only writes the tail and the consumer only writes the head, each on its own cache
+ * line, so pushing and popping never contend on the same line nor take a lock.
+ *
+ * @tparam T Trivially copyable element
+ * @tparam Capacity Number of slots, a power of two
+ */
+template <typename T, size_t Capacity>
+class SpscRing
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "Ring capacity must be a power of two");
+
+public:
+    /**
+     * @brief Append an element, producer thread only
+     *
+     * @param value Element
+     * @return false if the ring is full
+     */
+    bool Push(const T &value)
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == Capacity)
+        {
+            return false;
+        }
+        m_slots[tail & (Capacity - 1)] = value;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Take the oldest element, consumer thread only
+     *
+     * @param value Output element
+     * @return false if the ring is empty
+     */
+    bool Pop(T &value)
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        value = m_slots[head & (Capacity - 1)];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Whether a push would fail, producer thread only
+     *
+     * @return true if full
+     */
+    bool Full() const
+    {
+        return m_tail.load(std::memory_order_relaxed) - m_head.load(std::memory_order_acquire) == Capacity;
+    }
+
+private:
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_head{0}; // Next slot to pop
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_tail{0}; // Next slot to push
+    alignas(CACHE_LINE_SIZE) T m_slots[Capacity];
+};
+
+/**
+ * @brief Kind of an input event kept by the input queue
+ *
+ */
+enum class InputEventKind : uint8_t
+{
+    KEY_DOWN,
+    KEY_UP,
+    MOUSE_DOWN,
+    MOUSE_UP
+};
+
+/**
+ * @brief Input event as drained from SDL, motion and window events are not queued
+ *
+ */
+struct InputEvent
+{
+    Uint64 timestamp;  // SDL event time in nanoseconds
+    SDL_Keycode key;   // Key of key events
+    InputEventKind kind;
+};
+
+/**
+ * @brief Game actions driven by the input, one bit each in an ActionState
+ *
+ */
+enum InputAction
+{
+    ACTION_LEFT,
+    ACTION_RIGHT,
+    ACTION_JUMP,
+    ACTION_PAINT
+};
+
+/**
+ * @brief Actions of one frame, reduced from all of the frame's input events
+ *
+ */
+struct ActionState
+{
+    uint32_t held{0};     // Actions active once every event of the frame is applied, kept across frames
+    uint32_t pressed{0};  // Actions activated at least once during the frame
+    uint32_t changed{0};  // Actions any event of the frame touched
+    Uint64 timestamp{0};  // Time of the latest event applied
+
+    /**
+     * @brief Start a new frame, keeping the held actions
+     *
+     */
+    void BeginFrame()
+    {
+        pressed = 0;
+        changed = 0;
+    }
+
+    /**
+     * @brief Activate or release an action
+     *
+     * @param action Action
+     * @param active New state
+     */
+    void Set(InputAction action, bool active)
+    {
+        uint32_t bit = 1u << action;
+        held = active ? held | bit : held & ~bit;
+        pressed |= active ? bit : 0;
+        changed |= bit;
+    }
+
+    /**
+     * @brief Fold an input event into the actions
+     *
+     * A key press cancels a pending jump unless it is the jump key itself, as the input always did.
+     *
+     * @param event Input event
+     */
+    void Apply(const InputEvent &event)
+    {
+        timestamp = event.timestamp;
+        switch (event.kind)
+        {
+        case InputEventKind::KEY_DOWN:
+            if (event.key == SDLK_a)
+            {
+                Set(ACTION_LEFT, true);
+            }
+            if (event.key == SDLK_d)
+            {
+                Set(ACTION_RIGHT, true);
+            }
+            Set(ACTION_JUMP, event.key == SDLK_SPACE);
+            break;
+        case InputEventKind::KEY_UP:
+            if (event.key == SDLK_a)
+            {
+                Set(ACTION_LEFT, false);
+            }
+            if (event.key == SDLK_d)
+            {
+                Set(ACTION_RIGHT, false);
+            }
+            break;
+        case InputEventKind::MOUSE_DOWN:
+            Set(ACTION_PAINT, true);
+            break;
+        case InputEventKind::MOUSE_UP:
+            Set(ACTION_PAINT, false);
+            break;
+        }
+    }
+
+    /**
+     * @brief Whether an action is in a set of actions
+     *
+     * @param actions held, pressed or changed
+     * @param action Action
+     * @return true if the action's bit is set
+     */
+    static bool Has(uint32_t actions, InputAction action)
+    {
+        return (actions >> action) & 1u;
+    }
+};
@@ -5,10 +5,16 @@
 #include "SceneView.hpp"
 #include "ImGuiLayer.hpp"
 #include "Board.hpp"
+#include "PhysicsThread.hpp"
+#include "InputQueue.hpp"
 
 /**
  * @brief Input handling system
  *
+ * Input runs in two halves. Poll drains the SDL events on the window thread into a lock free queue,
+ * Apply reduces the queued events to one ActionState and writes it to every InputComponent in a
+ * single pass, so a flood of events costs one pass over the entities per frame. Each half may run
+ * on its own thread.
  */
 class InputSystem
 {
@@ -29,16 +35,40 @@ public:
     /**
      * @brief Handle user input events
      *
-     * @param deltaTime Time since last frame
-     * @param physicsWorld Box2D physics world
-     * @return true Application should quit
-     * @return false Application should continue
+     * @param physics Thread stepping the Box2D physics world
+     * @return true Application should continue
+     * @return false Application should quit
      */
-    bool Input(b2World *physicsWorld) const;
+    bool Input(PhysicsThread *physics);
+
+    /**
+     * @brief Drain the SDL events, forward them to ImGui and queue the game input, window thread only
+     *
+     * @return true Application should continue
+     * @return false Application should quit
+     */
+    bool Poll();
+
+    /**
+     * @brief Reduce the queued events to this frame's actions and apply them to the scene, simulation thread only
+     *
+     * @param physics Thread stepping the Box2D physics world
+     */
+    void Apply(PhysicsThread *physics);
 
 private:
+    /**
+     * @brief Paint the selected grid or sprite sheet under the mouse, or select the entity under it
+     *
+     * @param physics Thread stepping the Box2D physics world
+     * @param pressed The button went down this frame, tiles and selection only react to that
+     */
+    void Paint(PhysicsThread *physics, bool pressed);
+
     Scene *const m_scene;
     SDLLayer *const m_sdlLayer;
     Board *const m_board;
     ImGuiLayer *const m_imguiLayer;
+    SpscRing<InputEvent, INPUT_RING_SIZE> m_events; // Written by Poll, read by Apply
+    ActionState m_actions;
 };
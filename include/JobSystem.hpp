@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Number of jobs submitted against it that have not finished yet
+ *
+ */
+struct JobCounter
+{
+    std::atomic<size_t> pending{0};
+};
+
+/**
+ * @brief Pool of worker threads with one job deque each
+ *
+ * A worker pushes and pops the jobs it spawns at the back of its own deque, so related work stays
+ * on the core that produced it. A worker whose deque is empty steals from the front of the others,
+ * the oldest and usually largest jobs. Threads outside the pool submit to a shared deque that the
+ * workers steal from as well. Waiting on a counter runs pending jobs instead of blocking, so a job
+ * can wait on the jobs it spawned. With no workers every job runs on the waiting thread.
+ */
+class JobSystem
+{
+public:
+    typedef std::function<void()> Job;
+
+    /**
+     * @brief Start the worker threads
+     *
+     * @param workerCount Worker threads, 0 runs every job on the thread waiting for it
+     */
+    explicit JobSystem(size_t workerCount = DefaultWorkerCount());
+
+    /**
+     * @brief Finish the submitted jobs and join the workers
+     *
+     */
+    ~JobSystem();
+
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    /**
+     * @brief Queue a job, counted by counter until it has run
+     *
+     * @param job Job
+     * @param counter Counter to wait on, must outlive the job
+     */
+    void Submit(Job job, JobCounter &counter);
+
+    /**
+     * @brief Run pending jobs on the calling thread until every job of counter has finished
+     *
+     * @param counter Counter
+     */
+    void Wait(JobCounter &counter);
+
+    /**
+     * @brief Run one pending job on the calling thread, stealing it if needed
+     *
+     * @return true if a job was run
+     */
+    bool RunPending();
+
+    /**
+     * @brief Number of worker threads
+     *
+     * @return size_t
+     */
+    size_t WorkerCount() const { return m_workers.size(); }
+
+    /**
+     * @brief One worker per hardware thread, leaving one for the main thread
+     *
+     * @return size_t
+     */
+    static size_t DefaultWorkerCount();
+
+private:
+    /**
+     * @brief A queued job and the counter it is accounted to
+     *
+     */
+    struct Task
+    {
+        Job job;
+        JobCounter *counter;
+    };
+
+    /**
+     * @brief Deque of one worker, the first one is fed by the threads outside the pool
+     *
+     */
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    /**
+     * @brief Take a job from the calling thread's own deque, or steal one from another deque
+     *
+     * @param task Output task
+     * @return true if a task was taken
+     */
+    bool Take(Task &task);
+
+    void WorkerLoop(size_t queueIndex);
+
+    std::vector<std::unique_ptr<WorkQueue>> m_queues; // Shared deque first, then one per worker
+    std::vector<std::thread> m_workers;
+    std::atomic<size_t> m_queued{0}; // Tasks waiting in any deque
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+    bool m_stopping = false;
+};
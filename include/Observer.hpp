@@ -0,0 +1,68 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include "Constants.hpp"
+
+struct Scene;
+
+/**
+ * @brief Type erased base of the observers of one component type
+ *
+ * Removals are queued through a plain function pointer, so removing an observed component costs a
+ * copy and no virtual call. Dispatch runs once per component type per sync point.
+ */
+struct ComponentObserverBase
+{
+    virtual ~ComponentObserverBase() = default;
+
+    /**
+     * @brief Call the handlers with the events collected since the previous dispatch
+     *
+     * @param scene Scene the component belongs to
+     * @param closing Tick closing this batch, the next dispatch reports changes made after it
+     */
+    virtual void Dispatch(Scene &scene, Tick closing) = 0;
+
+    void (*queueRemoved)(ComponentObserverBase *pObserver, EntityID id, const void *pComponent){nullptr};
+    Tick since{0}; // Tick closing the previous batch
+};
+
+/**
+ * @brief Handlers subscribed to the lifecycle events of component T
+ *
+ * Additions and changes are not recorded as they happen: at dispatch they are read from the change
+ * ticks the scene already stamps, so observing them costs nothing until the sync point. Removed
+ * components are copied into a queue before they are destroyed, so handlers still see their last
+ * value (the b2Body of a collider for instance).
+ *
+ * @tparam T Component
+ */
+template <typename T>
+struct ComponentObserver : ComponentObserverBase
+{
+    typedef std::function<void(Scene &, const std::vector<EntityID> &)> Handler;
+    typedef std::function<void(Scene &, const std::vector<EntityID> &, const std::vector<T> &)> RemoveHandler;
+
+    ComponentObserver()
+    {
+        queueRemoved = [](ComponentObserverBase *pObserver, EntityID id, const void *pComponent)
+        {
+            ComponentObserver *pSelf = static_cast<ComponentObserver *>(pObserver);
+            if (!pSelf->onRemove.empty())
+            {
+                pSelf->removedIds.push_back(id);
+                pSelf->removed.push_back(*static_cast<const T *>(pComponent));
+            }
+        };
+    }
+
+    void Dispatch(Scene &scene, Tick closing) override;
+
+    std::vector<Handler> onAdd;
+    std::vector<Handler> onSet;
+    std::vector<RemoveHandler> onRemove;
+    std::vector<EntityID> removedIds; // Entities whose component was removed, as they were at the time
+    std::vector<T> removed;           // Last value of each removed component
+    std::vector<EntityID> batch;      // Entities of the add or set batch being dispatched
+};
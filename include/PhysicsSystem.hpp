@@ -3,10 +3,13 @@
 #include "Scene.hpp"
 #include "SceneView.hpp"
 #include "Board.hpp"
+#include "SystemScheduler.hpp"
 
 /**
  * @brief Physics System
  *
+ * The passes never touch the world directly: positions and contacts are read from the snapshot of
+ * the scene's PhysicsThread and impulses are queued on it, so they run while the world is stepping.
  */
 class PhysicsSystem
 {
@@ -23,10 +26,11 @@ public:
     }
 
     /**
-     * @brief Update the Physics System
+     * @brief Add the physics passes to a scheduler with the components each of them touches
      *
+     * @param scheduler Scheduler running the passes every frame
      */
-    void Update() const;
+    void Register(SystemScheduler &scheduler) const;
 
 private:
     Scene *const m_scene;
@@ -50,6 +54,12 @@ private:
      */
     void UpdateTransforms() const;
 
+    /**
+     * @brief Advance the falling sand simulation of every grid
+     *
+     */
+    void UpdateGrids() const;
+
     void UpdateSand(int row, int col, GridSimulationComponent *grid, std::vector<particle_t> &newGrid) const;
 
     void UpdateWater(int row, int col, GridSimulationComponent *grid, std::vector<particle_t> &newGrid) const;
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <box2d/box2d.h>
+#include "Constants.hpp"
+
+/**
+ * @brief Steps a Box2D world on a thread of its own
+ *
+ * Step starts a step and returns at once. While it runs the world belongs to the physics thread:
+ * systems read body positions and contacts from the snapshot of the previous step, and impulses,
+ * teleports and clamps are queued and applied right before the next step. Anything else touching the world
+ * goes through World, which waits for the step in flight.
+ *
+ * The snapshot is double buffered. The step writes one buffer while the systems read the other,
+ * and the next Step swaps them once the step has finished, so the snapshot never changes between
+ * two calls to Step.
+ */
+class PhysicsThread
+{
+public:
+    /**
+     * @brief Start the physics thread, idle until the first Step
+     *
+     * @param world World stepped by the thread, must outlive it
+     */
+    explicit PhysicsThread(b2World *world);
+
+    /**
+     * @brief Finish the step in flight and join the thread
+     *
+     */
+    ~PhysicsThread();
+
+    PhysicsThread(const PhysicsThread &) = delete;
+    PhysicsThread &operator=(const PhysicsThread &) = delete;
+
+    /**
+     * @brief Publish the finished step and start the next one with the queued commands
+     *
+     * @param timeStep Seconds to simulate
+     * @param velocityIterations Velocity iterations of the solver
+     * @param positionIterations Position iterations of the solver
+     */
+    void Step(float timeStep, int32 velocityIterations, int32 positionIterations);
+
+    /**
+     * @brief Wait for the step in flight and get the world, idle until the next Step
+     *
+     * Bodies must be destroyed with DestroyBody or after Reset, queued commands may point to them.
+     *
+     * @return b2World*
+     */
+    b2World *World();
+
+    /**
+     * @brief Queue an impulse at the center of a body for the next step, safe from any thread
+     *
+     * @param body Body
+     * @param impulse Impulse in N.s
+     */
+    void ApplyImpulse(b2Body *body, const b2Vec2 &impulse);
+
+    /**
+     * @brief Queue a move of a body for the next step, safe from any thread
+     *
+     * @param body Body
+     * @param position Position in meters
+     */
+    void SetTransform(b2Body *body, const b2Vec2 &position);
+
+    /**
+     * @brief Queue keeping a body inside a box for the next step, safe from any thread
+     *
+     * The body's position is clamped when the command is applied, so an axis already inside the
+     * box keeps the position reached by the step in flight.
+     *
+     * @param body Body
+     * @param lower Lowest position in meters
+     * @param upper Highest position in meters
+     */
+    void ClampPosition(b2Body *body, const b2Vec2 &lower, const b2Vec2 &upper);
+
+    /**
+     * @brief Wait for the step in flight, forget the commands and snapshot of a body and destroy it
+     *
+     * @param body Body
+     */
+    void DestroyBody(b2Body *body);
+
+    /**
+     * @brief Wait for the step in flight and forget every command and snapshot, before destroying all bodies through World
+     *
+     */
+    void Reset();
+
+    /**
+     * @brief Position of the body of an entity at the end of the last published step
+     *
+     * @param entity Entity the body belongs to
+     * @param position Output position in meters, untouched if the body was created since
+     * @return true if the snapshot holds the body
+     */
+    bool GetPosition(EntityID entity, b2Vec2 &position) const;
+
+    /**
+     * @brief Contacts of the body of an entity at the end of the last published step
+     *
+     * @param entity Entity the body belongs to
+     * @return uint32_t
+     */
+    uint32_t GetContactCount(EntityID entity) const;
+
+private:
+    /**
+     * @brief State of one body in a snapshot, indexed by entity index
+     *
+     */
+    struct BodyState
+    {
+        EntityID entity{EntityID(-1)}; // Tells a stale slot from a reused entity index
+        b2Vec2 position{0.0f, 0.0f};
+        uint32_t contacts{0};
+    };
+
+    enum class CommandKind : uint8_t
+    {
+        IMPULSE,
+        TELEPORT,
+        CLAMP
+    };
+
+    /**
+     * @brief Impulse, teleport or clamp waiting for the next step
+     *
+     */
+    struct BodyCommand
+    {
+        b2Body *body;
+        b2Vec2 value; // Impulse, position, or lower corner of a clamp
+        b2Vec2 upper; // Upper corner of a clamp
+        CommandKind kind;
+    };
+
+    /**
+     * @brief Block until the step in flight, if any, has finished
+     *
+     */
+    void Wait();
+
+    /**
+     * @brief Apply the commands, step the world and write the back snapshot, on the physics thread
+     *
+     */
+    void RunStep();
+
+    void ThreadLoop();
+
+    const BodyState *Find(EntityID entity) const;
+
+    b2World *const m_world;
+    std::vector<BodyState> m_states[2];
+    int m_front{0};                          // Snapshot the systems read, the step writes the other one
+    std::vector<BodyCommand> m_commands;     // Queued for the next step
+    std::vector<BodyCommand> m_stepCommands; // Taken by the step in flight
+    std::mutex m_commandMutex;
+    float m_timeStep{0.0f};
+    int32 m_velocityIterations{0};
+    int32 m_positionIterations{0};
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stepping{false}; // A step was started and has not finished
+    bool m_stop{false};
+    std::thread m_thread;
+};
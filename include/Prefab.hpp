@@ -0,0 +1,140 @@
+#pragma once
+
+#include <array>
+#include <new>
+#include <type_traits>
+#include "ComponentInfo.hpp"
+#include "ComponentRegistry.hpp"
+#include "Constants.hpp"
+
+/**
+ * @brief Set of component values copied into every entity created from it
+ *
+ * Used with Scene::CreateEntities to spawn many entities sharing one archetype. Only copyable
+ * components can be part of a prefab.
+ */
+struct Prefab
+{
+    Prefab() = default;
+
+    /**
+     * @brief Destroy the Prefab object and its component values
+     *
+     */
+    ~Prefab()
+    {
+        for (size_t componentId = 0; componentId < COMPONENT_COUNT; componentId++)
+        {
+            Release(int(componentId));
+        }
+    }
+
+    Prefab(const Prefab &) = delete;
+    Prefab &operator=(const Prefab &) = delete;
+
+    /**
+     * @brief Add a component to the prefab, replacing an existing value
+     *
+     * @tparam T Component
+     * @return T* Default constructed value to fill in
+     */
+    template <typename T>
+    T *Assign()
+    {
+        static_assert(std::is_copy_constructible<T>::value, "Prefab components must be copyable");
+        constexpr int componentId = ComponentTraits<T>::ID;
+        Release(componentId);
+        T *pComponent = new (::operator new(sizeof(T), std::align_val_t(alignof(T)))) T();
+        values[componentId] = pComponent;
+        mask.set(componentId);
+        return pComponent;
+    }
+
+    /**
+     * @brief Get the value of a component of the prefab
+     *
+     * @tparam T Component
+     * @return T* nullptr if the prefab does not have the component
+     */
+    template <typename T>
+    T *Get()
+    {
+        return static_cast<T *>(values[ComponentTraits<T>::ID]);
+    }
+
+    ComponentMask mask;                           // Components of the created entities
+    std::array<void *, COMPONENT_COUNT> values{}; // Prototype of each component, indexed by component id
+
+private:
+    /**
+     * @brief Destroy and free the value of a component
+     *
+     * @param componentId Component id
+     */
+    void Release(int componentId)
+    {
+        if (values[componentId] == nullptr)
+        {
+            return;
+        }
+        const ComponentInfo &info = RegisteredComponents()[componentId];
+        if (info.destroy)
+        {
+            info.destroy(values[componentId]);
+        }
+        ::operator delete(values[componentId], std::align_val_t(info.alignment));
+        values[componentId] = nullptr;
+        mask.reset(componentId);
+    }
+};
+
+/**
+ * @brief Contiguous range of entities returned by Scene::CreateEntities
+ *
+ * Entities created in bulk occupy consecutive fresh indices, all at version 0.
+ */
+struct EntityRange
+{
+    /**
+     * @brief Iterator over the entity ids of the range
+     *
+     */
+    struct Iterator
+    {
+        EntityIndex index;
+
+        EntityID operator*() const
+        {
+            return (EntityID)index << 32;
+        }
+
+        Iterator &operator++()
+        {
+            index++;
+            return *this;
+        }
+
+        bool operator!=(const Iterator &other) const
+        {
+            return index != other.index;
+        }
+    };
+
+    /**
+     * @brief Get the id of the entity at a position of the range
+     *
+     * @param i Position, less than count
+     * @return EntityID
+     */
+    EntityID operator[](size_t i) const
+    {
+        return (EntityID)(first + EntityIndex(i)) << 32;
+    }
+
+    Iterator begin() const { return {first}; }
+    Iterator end() const { return {first + EntityIndex(count)}; }
+    size_t size() const { return count; }
+
+    EntityIndex first{0};
+    size_t count{0};
+};
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <tuple>
+
+/**
+ * @brief View filter rejecting entities that have component T
+ *
+ * @tparam T Component
+ */
+template <typename T>
+struct Without
+{
+};
+
+/**
+ * @brief View filter fetching component T as a const pointer, nullptr when the entity lacks it
+ *
+ * @tparam T Component
+ */
+template <typename T>
+struct Optional
+{
+};
+
+/**
+ * @brief View filter requiring component T without fetching it, used for tag components
+ *
+ * @tparam T Component
+ */
+template <typename T>
+struct With
+{
+};
+
+/**
+ * @brief View filter requiring component T and fetching it by reference, marking it changed
+ *
+ * @tparam T Component
+ */
+template <typename T>
+struct Mut
+{
+};
+
+/**
+ * @brief View filter requiring component T changed since the tick the view was built with
+ *
+ * @tparam T Component
+ */
+template <typename T>
+struct Changed
+{
+};
+
+/**
+ * @brief View filter requiring component T assigned since the tick the view was built with
+ *
+ * @tparam T Component
+ */
+template <typename T>
+struct Added
+{
+};
+
+/**
+ * @brief Change tick a term compares against the tick a view was built with
+ *
+ */
+enum class TickFilter
+{
+    NONE,
+    ADDED,
+    CHANGED
+};
+
+/**
+ * @brief Compile time description of a SceneView term
+ *
+ * A plain component is required and fetched by const reference, Mut<T> is fetched for writing.
+ * INCLUDE and EXCLUDE select the mask the component id is written to, Fetched is the part of the
+ * each() tuple produced by the term. TICK selects a per entity change tick test and MARK stamps
+ * the component changed and unshares its page when it is fetched.
+ *
+ * @tparam T Component or filter
+ */
+template <typename T>
+struct QueryTerm
+{
+    typedef T Component;
+    typedef std::tuple<const T &> Fetched;
+    static constexpr bool INCLUDE = true;
+    static constexpr bool EXCLUDE = false;
+    static constexpr bool FETCH = true;
+    static constexpr TickFilter TICK = TickFilter::NONE;
+    static constexpr bool MARK = false;
+
+    static Fetched Fetch(const void *pComponent)
+    {
+        return Fetched(*static_cast<const T *>(pComponent));
+    }
+};
+
+template <typename T>
+struct QueryTerm<Without<T>>
+{
+    typedef T Component;
+    typedef std::tuple<> Fetched;
+    static constexpr bool INCLUDE = false;
+    static constexpr bool EXCLUDE = true;
+    static constexpr bool FETCH = false;
+    static constexpr TickFilter TICK = TickFilter::NONE;
+    static constexpr bool MARK = false;
+
+    static Fetched Fetch(const void *)
+    {
+        return Fetched();
+    }
+};
+
+template <typename T>
+struct QueryTerm<Optional<T>>
+{
+    typedef T Component;
+    typedef std::tuple<const T *> Fetched;
+    static constexpr bool INCLUDE = false;
+    static constexpr bool EXCLUDE = false;
+    static constexpr bool FETCH = true;
+    static constexpr TickFilter TICK = TickFilter::NONE;
+    static constexpr bool MARK = false;
+
+    static Fetched Fetch(const void *pComponent)
+    {
+        return Fetched(static_cast<const T *>(pComponent));
+    }
+};
+
+template <typename T>
+struct QueryTerm<With<T>>
+{
+    typedef T Component;
+    typedef std::tuple<> Fetched;
+    static constexpr bool INCLUDE = true;
+    static constexpr bool EXCLUDE = false;
+    static constexpr bool FETCH = false;
+    static constexpr TickFilter TICK = TickFilter::NONE;
+    static constexpr bool MARK = false;
+
+    static Fetched Fetch(const void *)
+    {
+        return Fetched();
+    }
+};
+
+template <typename T>
+struct QueryTerm<Mut<T>> : QueryTerm<T>
+{
+    typedef std::tuple<T &> Fetched;
+    static constexpr bool MARK = true;
+
+    static Fetched Fetch(void *pComponent)
+    {
+        return Fetched(*static_cast<T *>(pComponent));
+    }
+};
+
+template <typename T>
+struct QueryTerm<Changed<T>> : QueryTerm<With<T>>
+{
+    static constexpr TickFilter TICK = TickFilter::CHANGED;
+};
+
+template <typename T>
+struct QueryTerm<Added<T>> : QueryTerm<With<T>>
+{
+    static constexpr TickFilter TICK = TickFilter::ADDED;
+};
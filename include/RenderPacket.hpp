@@ -0,0 +1,129 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Draw order of the layers, lower layers are drawn first
+ *
+ */
+enum RenderLayer
+{
+    SPRITE_LAYER,
+    SPRITESHEET_LAYER,
+    GRID_LAYER,
+    COLLIDER_LAYER
+};
+
+/**
+ * @brief Kind of primitive a DrawCommand draws
+ *
+ */
+enum class DrawKind : uint8_t
+{
+    TEXTURE,   // Texture, or a sample of it, stretched over dst
+    RECTANGLE, // Outline of dst in color
+    GRID       // One point per cell, dst holds the columns and rows
+};
+
+/**
+ * @brief Everything needed to draw one primitive, copied out of the scene
+ *
+ */
+struct DrawCommand
+{
+    SDL_Texture *texture{nullptr}; // Owned by the ResourceManager or a sprite sheet, outlives the packet
+    SDL_FRect src{0, 0, 0, 0};     // Sample of the texture, an empty rect draws the whole texture
+    SDL_FRect dst{0, 0, 0, 0};     // Destination in viewport pixels
+    SDL_Color color{255, 255, 255, 255};
+    int layer{SPRITE_LAYER};
+    DrawKind kind{DrawKind::TEXTURE};
+    uint32_t firstCell{0}; // Grid only, first cell color in RenderPacket::cells
+};
+
+/**
+ * @brief Draw data of one frame, submitted without touching the scene
+ *
+ */
+struct RenderPacket
+{
+    std::vector<DrawCommand> commands;
+    std::vector<SDL_Color> cells; // Cell colors of the grids, row by row
+    bool showGrid{false};         // Draw the board lines over the scene
+
+    /**
+     * @brief Empty the packet, keeping its memory for the next frame
+     *
+     */
+    void Clear()
+    {
+        commands.clear();
+        cells.clear();
+    }
+
+    /**
+     * @brief Order the commands by layer, keeping the extraction order within a layer
+     *
+     */
+    void SortByLayer()
+    {
+        std::stable_sort(commands.begin(), commands.end(), [](const DrawCommand &a, const DrawCommand &b)
+                         { return a.layer < b.layer; });
+    }
+};
+
+/**
+ * @brief Triple buffered render packets handed from the extraction to the submission
+ *
+ * The extraction fills the back packet and publishes it, the submission takes the latest published
+ * packet. Neither side ever waits for the other or sees a packet being written: publishing swaps
+ * the back packet with the middle one, acquiring swaps the front packet with the middle one if a
+ * newer frame was published since, and keeps drawing the front packet otherwise.
+ */
+struct FramePackets
+{
+    /**
+     * @brief Packet the extraction writes, owned by the producer until Publish
+     *
+     * @return RenderPacket&
+     */
+    RenderPacket &Back()
+    {
+        return packets[back];
+    }
+
+    /**
+     * @brief Hand the back packet to the submission and start writing another one
+     *
+     */
+    void Publish()
+    {
+        back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    /**
+     * @brief Latest published packet, owned by the consumer until the next Acquire
+     *
+     * @return const RenderPacket&
+     */
+    const RenderPacket &Acquire()
+    {
+        if (middle.load(std::memory_order_relaxed) & FRESH)
+        {
+            front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+        }
+        return packets[front];
+    }
+
+private:
+    static constexpr unsigned FRESH = 4; // Set on middle when it holds a packet not acquired yet
+    static constexpr unsigned INDEX = 3;
+
+    RenderPacket packets[3];
+    unsigned front{0};
+    unsigned back{2};
+    std::atomic<unsigned> middle{1};
+};
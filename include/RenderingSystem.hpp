@@ -4,10 +4,14 @@
 #include "SDLLayer.hpp"
 #include "SceneView.hpp"
 #include "ImGuiLayer.hpp"
+#include "RenderPacket.hpp"
 
 /**
  * @brief Rendering System
  *
+ * Rendering is split in two phases. Extract copies the draw data of the scene into a render packet
+ * once the frame is simulated, Submit draws the latest packet without reading the scene, so it can
+ * run while the systems of the next frame are updating the components.
  */
 class RenderingSystem
 {
@@ -30,16 +34,29 @@ public:
      */
     ~RenderingSystem()
     {
+        SDL_DestroyTexture(m_viewportTexture);
         delete m_imguiLayer;
         delete m_sdlLayer;
     }
 
     /**
-     * @brief Renders the ImGui Editor and the SDL scene to the ImGui Window as a texture
+     * @brief Renders the ImGui Editor with the last submitted SDL scene in the ImGui Window as a texture
      *
      */
     void Render();
 
+    /**
+     * @brief Copy the draw data of the scene into a render packet and publish it for Submit
+     *
+     */
+    void Extract();
+
+    /**
+     * @brief Draw the latest published render packet to the SDL Viewport texture
+     *
+     */
+    void Submit();
+
     /**
      * @brief Get an SDL Texture of the SDL Viewport
      *
@@ -48,11 +65,11 @@ public:
     SDL_Texture *GetWindowTexture();
 
     /**
-     * @brief Render the SDL scene to the renderer
+     * @brief Render a render packet to the renderer
      *
-     * @param showColliders Render colliders to SDL
+     * @param packet Draw data of a frame
      */
-    void SDLRender(bool &showColliders) const;
+    void SDLRender(const RenderPacket &packet) const;
 
     /**
      * @brief Get the Im Gui Layer object
@@ -73,5 +90,7 @@ private:
     Board *const m_board;
     SDLLayer *const m_sdlLayer = new SDLLayer();
     ImGuiLayer *m_imguiLayer = new ImGuiLayer(m_scene, m_sdlLayer->GetRenderer(), m_sdlLayer->GetWindow(), m_board);
-    SDL_Texture *m_viewportTexture;
+    SDL_Texture *m_viewportTexture{nullptr};
+    SharedGroups<SpriteComponent, TransformComponent> m_spriteGroups{*m_scene}; // Sprites grouped by shared value, rebuilt each frame
+    FramePackets m_packets;                                                    // Extracted frames waiting for Submit
 };
\ No newline at end of file
@@ -128,15 +128,22 @@ public:
         SDL_RenderTexture(m_renderer, texture, &srcRect, &dstRect);
     }
 
-    void DrawGrid(int rows, int cols, std::vector<particle_t> *gridData)
+    /**
+     * @brief Draw a grid with one point per cell
+     *
+     * @param rows
+     * @param cols
+     * @param cells Cell colors, row by row
+     */
+    void DrawGrid(int rows, int cols, const SDL_Color *cells)
     {
         for (int i = 0; i < rows; i++)
         {
             for (int j = 0; j < cols; j++)
             {
                 // SDL Draw Pixel
-                const particle_t &particle = gridData->at(i * cols + j);
-                SDL_SetRenderDrawColor(m_renderer, particle.color.r, particle.color.g, particle.color.b, particle.color.a);
+                const SDL_Color &color = cells[i * cols + j];
+                SDL_SetRenderDrawColor(m_renderer, color.r, color.g, color.b, color.a);
                 SDL_RenderPoint(m_renderer, j, i);
             }
         }
@@ -2,52 +2,720 @@
 
 #include <iostream>
 #include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <SDL3/SDL.h>
 #include "Spritesheet.hpp"
 #include "Components.hpp"
 #include "Constants.hpp"
+#include "ComponentInfo.hpp"
+#include "ComponentRegistry.hpp"
+#include "Archetype.hpp"
+#include "SceneQuery.hpp"
+#include "CommandBuffer.hpp"
+#include "Prefab.hpp"
+#include "TransformHierarchy.hpp"
+#include "SpatialIndex.hpp"
+#include "Arena.hpp"
+#include "Observer.hpp"
+#include "JobSystem.hpp"
+
+class PhysicsThread;
+struct ComponentPool;
+
+/**
+ * @brief Pools using a component page since a fork
+ *
+ * The owner is the pool the page was forked from and writes it in place. Borrowers are forks
+ * reading it: a borrower writing the page takes a copy of its own, and the owner writing it first
+ * hands a copy to every borrower, so the owner's components never move. The page has the same
+ * index in every pool sharing it.
+ */
+struct SharedPage
+{
+    ComponentPool *owner;                   // Pool keeping the page when it is unshared
+    std::vector<ComponentPool *> borrowers; // Forks copying the page before writing it
+};
+
+/**
+ * @brief Page of the dense storage of a pool and its sharing state
+ *
+ * Both are atomic since the systems of a scene read the pool while one of them may be unsharing a
+ * page. Copying a slot is only done while nothing else uses the pool.
+ */
+struct PageSlot
+{
+    PageSlot(char *pData, SharedPage *pShared = nullptr) : data(pData), shared(pShared) {}
+    PageSlot(const PageSlot &other) : data(other.data.load(std::memory_order_relaxed)), shared(other.shared.load(std::memory_order_relaxed)) {}
+
+    std::atomic<char *> data;         // First component of the page
+    std::atomic<SharedPage *> shared; // Sharing state, null while the page belongs to this pool alone
+};
 
 /**
- * @brief Bitmask storage for each entities components
+ * @brief Sparse set storage for a single component type
  *
+ * Components are packed into a dense array (split into fixed size pages so growing never moves
+ * existing components) and located through a paged sparse index keyed by entity index. The
+ * lifecycle table of the component type lets the pool destroy and relocate components without
+ * knowing their type, so removing keeps the array packed and releases what the component owns.
+ *
+ * Pages can be shared copy-on-write with the pool of a forked scene, see SharedPage. Writes go
+ * through get(), at() and page(), which unshare the page before handing out a pointer into it.
+ * read(), readAt() and readPage() read a shared page in place, so reading a fork costs no copy.
  */
 struct ComponentPool
 {
     /**
-     * @brief Construct a new Component Pool object based on Component size
+     * @brief Construct a new Component Pool object for a component type
      *
-     * @param elementsize
+     * @param componentInfo Size, alignment and lifecycle functions of the component
      */
-    ComponentPool(size_t elementsize)
+    ComponentPool(const ComponentInfo &componentInfo) : info(componentInfo)
     {
-        // We'll allocate enough memory to hold MAX_ENTITIES, each with element size
-        elementSize = elementsize;
-        pData = new char[elementSize * MAX_ENTITIES];
+        scratch = ::operator new(info.size, std::align_val_t(std::max(info.alignment, alignof(std::max_align_t))));
     }
 
     /**
-     * @brief Destroy the Component Pool object
+     * @brief Destroy the Component Pool object and every component left in it
      *
      */
     ~ComponentPool()
     {
-        delete[] pData;
+        clear();
+        for (PageSlot &slot : pages)
+        {
+            ::operator delete(slot.data.load(std::memory_order_relaxed), std::align_val_t(CACHE_LINE_SIZE));
+        }
+        for (EntityIndex *page : sparse)
+        {
+            delete[] page;
+        }
+        ::operator delete(scratch, std::align_val_t(std::max(info.alignment, alignof(std::max_align_t))));
+    }
+
+    ComponentPool(const ComponentPool &) = delete;
+    ComponentPool &operator=(const ComponentPool &) = delete;
+
+    /**
+     * @brief Check if the entity at index has a component in this pool
+     *
+     * @param index Entity index
+     * @return true if the component exists
+     */
+    inline bool contains(EntityIndex index) const
+    {
+        size_t page = index / SPARSE_PAGE_SIZE;
+        return page < sparse.size() && sparse[page] && sparse[page][index % SPARSE_PAGE_SIZE] != EntityIndex(-1);
+    }
+
+    /**
+     * @brief Get the component value at the desired entity index
+     *
+     * @param index Entity index, must be contained in the pool
+     * @return void*
+     */
+    inline void *get(EntityIndex index)
+    {
+        return at(sparse[index / SPARSE_PAGE_SIZE][index % SPARSE_PAGE_SIZE]);
+    }
+
+    /**
+     * @brief Get the component value at the desired entity index for reading, a shared page is not copied
+     *
+     * @param index Entity index, must be contained in the pool
+     * @return const void*
+     */
+    inline const void *read(EntityIndex index) const
+    {
+        return readAt(sparse[index / SPARSE_PAGE_SIZE][index % SPARSE_PAGE_SIZE]);
+    }
+
+    /**
+     * @brief Get the position of the component of an entity in the dense array
+     *
+     * @param index Entity index, must be contained in the pool
+     * @return size_t
+     */
+    inline size_t denseIndexOf(EntityIndex index) const
+    {
+        return sparse[index / SPARSE_PAGE_SIZE][index % SPARSE_PAGE_SIZE];
     }
 
     /**
-     * @brief Get the component value at the desired index
+     * @brief Get the component value at a position of the dense array
      *
-     * @param index
+     * @param denseIndex Position in the dense array
      * @return void*
      */
-    inline void *get(size_t index)
+    inline void *at(size_t denseIndex)
+    {
+        return page(denseIndex / COMPONENT_PAGE_SIZE) + (denseIndex % COMPONENT_PAGE_SIZE) * info.size;
+    }
+
+    /**
+     * @brief Get the component value at a position of the dense array for reading
+     *
+     * @param denseIndex Position in the dense array
+     * @return const void*
+     */
+    inline const void *readAt(size_t denseIndex) const
+    {
+        return readPage(denseIndex / COMPONENT_PAGE_SIZE) + (denseIndex % COMPONENT_PAGE_SIZE) * info.size;
+    }
+
+    /**
+     * @brief Get a page of the dense storage for reading, a shared page is read in place
+     *
+     * @param pageIndex Page index
+     * @return const char* First component of the page
+     */
+    inline const char *readPage(size_t pageIndex) const
+    {
+        return pages[pageIndex].data.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Get a page of the dense storage for writing, unsharing it first if it is shared
+     *
+     * @param pageIndex Page index
+     * @return char* First component of the page
+     */
+    inline char *page(size_t pageIndex)
+    {
+        PageSlot &slot = pages[pageIndex];
+        if (slot.shared.load(std::memory_order_acquire))
+        {
+            // Systems using the pool concurrently must not unshare the page twice
+            std::lock_guard<std::mutex> lock(shareMutex);
+            if (slot.shared.load(std::memory_order_relaxed))
+            {
+                unshare(pageIndex);
+            }
+        }
+        return slot.data.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Number of components stored in a page
+     *
+     * @param pageIndex Page index
+     * @return size_t
+     */
+    inline size_t liveCount(size_t pageIndex) const
+    {
+        size_t begin = pageIndex * COMPONENT_PAGE_SIZE;
+        return dense.size() > begin ? std::min(COMPONENT_PAGE_SIZE, dense.size() - begin) : 0;
+    }
+
+    /**
+     * @brief Create a pool with the same components, sharing every page copy-on-write
+     *
+     * The index and the change ticks are copied, the components are only copied page by page
+     * when either pool writes to them. The copy borrows every page: this pool keeps its pages
+     * whichever pool writes first.
+     *
+     * @return ComponentPool* Owned by the caller
+     */
+    ComponentPool *fork()
+    {
+        ComponentPool *pCopy = new ComponentPool(info);
+        pCopy->pages.reserve(pages.size());
+        {
+            std::lock_guard<std::mutex> lock(shareMutex);
+            for (PageSlot &slot : pages)
+            {
+                // A page this pool borrows is lent to the copy by the same owner
+                SharedPage *pShared = slot.shared.load(std::memory_order_relaxed);
+                if (pShared == nullptr)
+                {
+                    pShared = new SharedPage{this, {}};
+                    slot.shared.store(pShared, std::memory_order_release);
+                }
+                pShared->borrowers.push_back(pCopy);
+                pCopy->pages.emplace_back(slot.data.load(std::memory_order_relaxed), pShared);
+            }
+        }
+        pCopy->dense = dense;
+        pCopy->ticks = ticks;
+        pCopy->sparse.resize(sparse.size(), nullptr);
+        for (size_t sparsePage = 0; sparsePage < sparse.size(); sparsePage++)
+        {
+            if (sparse[sparsePage])
+            {
+                pCopy->sparse[sparsePage] = new EntityIndex[SPARSE_PAGE_SIZE];
+                std::copy(sparse[sparsePage], sparse[sparsePage] + SPARSE_PAGE_SIZE, pCopy->sparse[sparsePage]);
+            }
+        }
+        return pCopy;
+    }
+
+    /**
+     * @brief Reserve a slot for the entity at index, growing the storage if needed
+     *
+     * A new slot is uninitialized and the caller constructs the component in it.
+     *
+     * @param index Entity index
+     * @return void* Memory for the component, the existing component if the entity already has one
+     */
+    void *emplace(EntityIndex index)
+    {
+        if (contains(index))
+        {
+            return get(index);
+        }
+
+        size_t page = index / SPARSE_PAGE_SIZE;
+        if (sparse.size() <= page)
+        {
+            sparse.resize(page + 1, nullptr);
+        }
+        if (sparse[page] == nullptr)
+        {
+            sparse[page] = new EntityIndex[SPARSE_PAGE_SIZE];
+            std::fill(sparse[page], sparse[page] + SPARSE_PAGE_SIZE, EntityIndex(-1));
+        }
+
+        if (dense.size() == pages.size() * COMPONENT_PAGE_SIZE)
+        {
+            addPage();
+        }
+
+        sparse[page][index % SPARSE_PAGE_SIZE] = EntityIndex(dense.size());
+        dense.push_back(index);
+        ticks.emplace_back();
+        return at(dense.size() - 1);
+    }
+
+    /**
+     * @brief Append copies of a prototype for a run of consecutive entity indices not in the pool
+     *
+     * Grows the index and the dense storage once, then fills each page with FillComponents.
+     *
+     * @param first First entity index
+     * @param count Number of entities
+     * @param prototype Component copied into every slot
+     * @param stamp Change ticks of the new components
+     */
+    void appendRange(EntityIndex first, size_t count, const void *prototype, ComponentTicks stamp)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
+        size_t lastPage = (first + count - 1) / SPARSE_PAGE_SIZE;
+        if (sparse.size() <= lastPage)
+        {
+            sparse.resize(lastPage + 1, nullptr);
+        }
+        for (size_t page = first / SPARSE_PAGE_SIZE; page <= lastPage; page++)
+        {
+            if (sparse[page] == nullptr)
+            {
+                sparse[page] = new EntityIndex[SPARSE_PAGE_SIZE];
+                std::fill(sparse[page], sparse[page] + SPARSE_PAGE_SIZE, EntityIndex(-1));
+            }
+        }
+
+        size_t start = dense.size();
+        dense.reserve(start + count);
+        for (size_t i = 0; i < count; i++)
+        {
+            EntityIndex index = first + EntityIndex(i);
+            sparse[index / SPARSE_PAGE_SIZE][index % SPARSE_PAGE_SIZE] = EntityIndex(start + i);
+            dense.push_back(index);
+        }
+        ticks.resize(start + count, stamp);
+
+        while (pages.size() * COMPONENT_PAGE_SIZE < dense.size())
+        {
+            addPage();
+        }
+        for (size_t denseIndex = start; denseIndex < dense.size();)
+        {
+            size_t run = std::min(COMPONENT_PAGE_SIZE - denseIndex % COMPONENT_PAGE_SIZE, dense.size() - denseIndex);
+            FillComponents(info, at(denseIndex), run, prototype);
+            denseIndex += run;
+        }
+    }
+
+    /**
+     * @brief Destroy the components of every marked entity in one compacting pass
+     *
+     * Cheaper than repeated erase calls when a large part of the pool goes away. The surviving
+     * components keep their relative order.
+     *
+     * @param marked Bitmap with one bit per entity index
+     */
+    void eraseMarked(const std::vector<uint64_t> &marked)
+    {
+        size_t kept = 0;
+        for (size_t denseIndex = 0; denseIndex < dense.size(); denseIndex++)
+        {
+            EntityIndex index = dense[denseIndex];
+            EntityIndex &slot = sparse[index / SPARSE_PAGE_SIZE][index % SPARSE_PAGE_SIZE];
+            if ((marked[index / 64] >> (index % 64)) & 1)
+            {
+                if (info.destroy)
+                {
+                    info.destroy(at(denseIndex));
+                }
+                slot = EntityIndex(-1);
+                continue;
+            }
+            if (kept != denseIndex)
+            {
+                info.relocate(at(kept), at(denseIndex));
+                ticks[kept] = ticks[denseIndex];
+                dense[kept] = index;
+                slot = EntityIndex(kept);
+            }
+            kept++;
+        }
+        dense.resize(kept);
+        ticks.resize(kept);
+        shrink();
+    }
+
+    /**
+     * @brief Reorder the dense storage so position i receives the component that was at order[i]
+     *
+     * @param order Source dense position of every destination position
+     */
+    void permute(const std::vector<uint32_t> &order)
+    {
+        PermuteComponents(info, order, [this](size_t denseIndex)
+                          { return at(denseIndex); });
+        PermuteValues(dense, order);
+        PermuteValues(ticks, order);
+        for (size_t denseIndex = 0; denseIndex < dense.size(); denseIndex++)
+        {
+            sparse[dense[denseIndex] / SPARSE_PAGE_SIZE][dense[denseIndex] % SPARSE_PAGE_SIZE] = EntityIndex(denseIndex);
+        }
+    }
+
+    /**
+     * @brief Exchange the components at two positions of the dense array
+     *
+     * @param a Dense position
+     * @param b Dense position
+     */
+    void swapDense(size_t a, size_t b)
+    {
+        if (a == b)
+        {
+            return;
+        }
+        info.relocate(scratch, at(a));
+        info.relocate(at(a), at(b));
+        info.relocate(at(b), scratch);
+        std::swap(dense[a], dense[b]);
+        std::swap(ticks[a], ticks[b]);
+        sparse[dense[a] / SPARSE_PAGE_SIZE][dense[a] % SPARSE_PAGE_SIZE] = EntityIndex(a);
+        sparse[dense[b] / SPARSE_PAGE_SIZE][dense[b] % SPARSE_PAGE_SIZE] = EntityIndex(b);
+    }
+
+    /**
+     * @brief Destroy the component of the entity at index, moving the last component into its slot
+     *
+     * @param index Entity index
+     */
+    void erase(EntityIndex index)
+    {
+        if (!contains(index))
+        {
+            return;
+        }
+
+        EntityIndex &slot = sparse[index / SPARSE_PAGE_SIZE][index % SPARSE_PAGE_SIZE];
+        size_t last = dense.size() - 1;
+        if (info.destroy)
+        {
+            info.destroy(at(slot));
+        }
+        if (slot != last)
+        {
+            // Keep the dense array packed by filling the hole with the last component
+            info.relocate(at(slot), at(last));
+            ticks[slot] = ticks[last];
+            dense[slot] = dense[last];
+            sparse[dense[slot] / SPARSE_PAGE_SIZE][dense[slot] % SPARSE_PAGE_SIZE] = slot;
+        }
+        slot = EntityIndex(-1);
+        dense.pop_back();
+        ticks.pop_back();
+
+        // Keep one spare page so an add/remove pattern at a page boundary does not thrash
+        if (pages.size() * COMPONENT_PAGE_SIZE >= dense.size() + 2 * COMPONENT_PAGE_SIZE)
+        {
+            shrink(1);
+        }
+    }
+
+    /**
+     * @brief Destroy every component in the pool, keeping the pages for reuse
+     *
+     */
+    void clear()
+    {
+        for (size_t pageIndex = 0; pageIndex < pages.size(); pageIndex++)
+        {
+            if (pages[pageIndex].shared.load(std::memory_order_acquire))
+            {
+                // The components stay with the other pools sharing the page
+                releasePage(pageIndex);
+                pages[pageIndex].data.store(static_cast<char *>(::operator new(info.size * COMPONENT_PAGE_SIZE, std::align_val_t(CACHE_LINE_SIZE))), std::memory_order_release);
+            }
+            else
+            {
+                destroyComponents(pages[pageIndex].data.load(std::memory_order_relaxed), liveCount(pageIndex));
+            }
+        }
+        for (EntityIndex index : dense)
+        {
+            sparse[index / SPARSE_PAGE_SIZE][index % SPARSE_PAGE_SIZE] = EntityIndex(-1);
+        }
+        dense.clear();
+        ticks.clear();
+    }
+
+    /**
+     * @brief Release the pages not holding any component
+     *
+     * @param spare Number of empty pages to keep after the used ones
+     */
+    void shrink(size_t spare = 0)
+    {
+        size_t used = (dense.size() + COMPONENT_PAGE_SIZE - 1) / COMPONENT_PAGE_SIZE;
+        while (pages.size() > used + spare)
+        {
+            releasePage(pages.size() - 1);
+            pages.pop_back();
+        }
+    }
+
+    /**
+     * @brief Get the change ticks of the component of the entity at index
+     *
+     * @param index Entity index, must be contained in the pool
+     * @return ComponentTicks&
+     */
+    inline ComponentTicks &ticksOf(EntityIndex index)
+    {
+        return ticks[sparse[index / SPARSE_PAGE_SIZE][index % SPARSE_PAGE_SIZE]];
+    }
+
+    /**
+     * @brief Number of components stored in the pool
+     *
+     * @return size_t
+     */
+    inline size_t size() const
+    {
+        return dense.size();
+    }
+
+    std::vector<EntityIndex> dense;     // Entity index owning each packed component
+    std::vector<EntityIndex *> sparse;  // Pages mapping entity index to dense position
+    std::vector<PageSlot> pages;        // Packed component storage
+    TickVector ticks;                   // Change ticks of each packed component
+    ComponentInfo info;                 // Size and lifecycle functions of the component
+    void *scratch{nullptr};             // Room for one component while swapping
+
+    // Held while the sharing state of any page changes, pools of different scenes share pages
+    static inline std::mutex shareMutex;
+
+private:
+    /**
+     * @brief Append an empty page to the dense storage
+     *
+     */
+    void addPage()
+    {
+        pages.emplace_back(static_cast<char *>(::operator new(info.size * COMPONENT_PAGE_SIZE, std::align_val_t(CACHE_LINE_SIZE))));
+    }
+
+    /**
+     * @brief Run the destructor of the first count components of a page
+     *
+     * @param pPage Page
+     * @param count Number of components
+     */
+    void destroyComponents(char *pPage, size_t count)
+    {
+        if (info.destroy)
+        {
+            for (size_t slot = 0; slot < count; slot++)
+            {
+                info.destroy(pPage + slot * info.size);
+            }
+        }
+    }
+
+    /**
+     * @brief Copy the first count components of a page into a new page
+     *
+     * @param pSource Page
+     * @param count Number of components
+     * @return char* New page
+     */
+    char *copyPage(const char *pSource, size_t count) const
+    {
+        char *pCopy = static_cast<char *>(::operator new(info.size * COMPONENT_PAGE_SIZE, std::align_val_t(CACHE_LINE_SIZE)));
+        if (info.trivial)
+        {
+            std::memcpy(pCopy, pSource, count * info.size);
+        }
+        else
+        {
+            for (size_t slot = 0; slot < count; slot++)
+            {
+                info.copy(pCopy + slot * info.size, pSource + slot * info.size);
+            }
+        }
+        return pCopy;
+    }
+
+    /**
+     * @brief Stop sharing a page before writing it, shareMutex must be held
+     *
+     * The owner keeps the page and gives every borrower a copy, a borrower takes a copy for itself.
+     *
+     * @param pageIndex Page index
+     */
+    void unshare(size_t pageIndex)
+    {
+        PageSlot &slot = pages[pageIndex];
+        SharedPage *pShared = slot.shared.load(std::memory_order_relaxed);
+        if (pShared->owner != this)
+        {
+            slot.data.store(copyPage(slot.data.load(std::memory_order_relaxed), liveCount(pageIndex)), std::memory_order_release);
+            leave(pageIndex);
+            return;
+        }
+
+        for (ComponentPool *pBorrower : pShared->borrowers)
+        {
+            PageSlot &borrowed = pBorrower->pages[pageIndex];
+            borrowed.data.store(copyPage(slot.data.load(std::memory_order_relaxed), pBorrower->liveCount(pageIndex)), std::memory_order_release);
+            borrowed.shared.store(nullptr, std::memory_order_release);
+        }
+        slot.shared.store(nullptr, std::memory_order_release);
+        delete pShared;
+    }
+
+    /**
+     * @brief Remove this pool from the pools sharing a page, shareMutex must be held
+     *
+     * An owner leaving hands the page over to one of the borrowers. The page stays in the slot.
+     *
+     * @param pageIndex Page index
+     */
+    void leave(size_t pageIndex)
     {
-        // looking up the component at the desired index
-        return pData + index * elementSize;
+        PageSlot &slot = pages[pageIndex];
+        SharedPage *pShared = slot.shared.load(std::memory_order_relaxed);
+        slot.shared.store(nullptr, std::memory_order_release);
+        if (pShared->owner == this)
+        {
+            pShared->owner = pShared->borrowers.back();
+            pShared->borrowers.pop_back();
+        }
+        else
+        {
+            pShared->borrowers.erase(std::find(pShared->borrowers.begin(), pShared->borrowers.end(), this));
+        }
+
+        if (pShared->borrowers.empty())
+        {
+            // The last pool using the page owns it alone
+            pShared->owner->pages[pageIndex].shared.store(nullptr, std::memory_order_release);
+            delete pShared;
+        }
     }
 
-    char *pData{nullptr};
-    size_t elementSize{0};
+    /**
+     * @brief Drop this pool's use of a page, freeing it and its components unless another pool shares it
+     *
+     * The page pointer is left dangling for the caller to replace or pop.
+     *
+     * @param pageIndex Page index
+     */
+    void releasePage(size_t pageIndex)
+    {
+        if (pages[pageIndex].shared.load(std::memory_order_acquire))
+        {
+            std::lock_guard<std::mutex> lock(shareMutex);
+            if (pages[pageIndex].shared.load(std::memory_order_relaxed))
+            {
+                leave(pageIndex);
+                return;
+            }
+        }
+        char *pPage = pages[pageIndex].data.load(std::memory_order_relaxed);
+        destroyComponents(pPage, liveCount(pageIndex));
+        ::operator delete(pPage, std::align_val_t(CACHE_LINE_SIZE));
+    }
+};
+
+/**
+ * @brief Component pools kept sorted so the entities having all of them come first, in the same order
+ *
+ * The first size positions of every owned pool hold the members of the group, position i of each
+ * pool belonging to the same entity. Iterating the group is a lockstep walk over the pools without
+ * any lookup. The scene swaps entities in as they gain the last owned component and out before they
+ * lose one. A pool can be owned by a single group.
+ */
+struct OwningGroup
+{
+    /**
+     * @brief Check if an entity is a member of the group
+     *
+     * @param index Entity index
+     * @return true if the entity has every owned component
+     */
+    inline bool Contains(EntityIndex index) const
+    {
+        return pools[0]->contains(index) && pools[0]->denseIndexOf(index) < size;
+    }
+
+    /**
+     * @brief Move an entity that just got every owned component to the end of the group
+     *
+     * @param index Entity index
+     */
+    void Enter(EntityIndex index)
+    {
+        for (ComponentPool *pool : pools)
+        {
+            pool->swapDense(pool->denseIndexOf(index), size);
+        }
+        size++;
+    }
+
+    /**
+     * @brief Move a member that is about to lose an owned component out of the group
+     *
+     * @param index Entity index
+     */
+    void Leave(EntityIndex index)
+    {
+        size--;
+        for (ComponentPool *pool : pools)
+        {
+            pool->swapDense(pool->denseIndexOf(index), size);
+        }
+    }
+
+    ComponentMask owned;
+    std::vector<ComponentPool *> pools; // Owned pools in component id order
+    size_t size{0};                     // Number of members, packed at the front of every owned pool
 };
 
 /**
@@ -66,6 +734,88 @@ struct Scene
         ComponentMask mask;
     };
 
+#ifdef ECS_ARCHETYPE_STORAGE
+    /**
+     * @brief Where the components of an entity are stored
+     *
+     */
+    struct EntityLocation
+    {
+        Archetype *archetype{nullptr};
+        size_t row{0};
+    };
+#endif
+
+    /**
+     * @brief Construct a new Scene object with a pool for every registered component
+     *
+     */
+    Scene();
+
+    /**
+     * @brief Destroy the Scene object, running the destructor of every remaining component
+     *
+     */
+    ~Scene();
+
+    /**
+     * @brief Create an independent copy of the scene for lookahead and what-if simulation
+     *
+     * With sparse sets the component pages are shared copy-on-write: forking costs the entity
+     * table and the pool indices, and a page is only copied once the fork or the parent accesses
+     * a component in it. The fork is always the side getting the copy, so pointers to the
+     * parent's components, including the references held by Python and the editor, stay valid.
+     * Pointers obtained from the fork must be fetched again after either scene accesses their
+     * page. With archetype storage the chunks are copied. Pending commands stay with the parent.
+     * Shared component stores are shared with the fork, so both scenes must be used from the same
+     * thread.
+     *
+     * @param physicsWorld World receiving copies of the colliders' bodies, with their velocities.
+     * Without one the fork's colliders keep referring to the parent's bodies and must not be simulated.
+     * @return Scene* New scene owned by the caller
+     */
+    Scene *Fork(b2World *physicsWorld = nullptr);
+
+    /**
+     * @brief Fork the scene together with a world of its own holding copies of the bodies
+     *
+     * The bodies are copied from ownedWorld for a fork, otherwise from the world of the scene's
+     * PhysicsThread once its step in flight has finished. The fork owns the new world and advances
+     * it with StepPhysics. Without a world to copy this is a plain Fork.
+     *
+     * @return Scene* New scene owned by the caller
+     */
+    Scene *ForkWithPhysics();
+
+    /**
+     * @brief Step the world owned by a fork and sync the collider positions and transforms to it
+     *
+     * Does nothing on a scene without ownedWorld, the application steps its world on the PhysicsThread.
+     *
+     * @param timeStep Seconds to simulate
+     * @param velocityIterations Velocity iterations of the solver
+     * @param positionIterations Position iterations of the solver
+     * @param pixelsPerMeter Size of a board tile, converts body positions to transforms
+     */
+    void StepPhysics(float timeStep, int32 velocityIterations, int32 positionIterations, float pixelsPerMeter);
+
+    /**
+     * @brief Tear down every entity of the level in one pass, keeping the storage warm for the next one
+     *
+     * Components are destroyed pool by pool (chunk by chunk with archetype storage) without
+     * per entity bookkeeping, queries and groups are emptied, and the level arena is reset.
+     * Component pages, archetype chunks, query lists and arena blocks keep their memory, so
+     * reloading a level allocates nothing until it grows past the previous one. Entity ids of the
+     * unloaded level must not be used afterwards. Forks keep pointing into the arena and must not
+     * outlive the level they were made from.
+     *
+     * @param physicsWorld World to destroy the colliders' bodies in, null if they were already destroyed
+     */
+    void UnloadLevel(b2World *physicsWorld = nullptr);
+
+    Scene(const Scene &) = delete;
+    Scene &operator=(const Scene &) = delete;
+
     /**
      * @brief Construct a new Entity object
      *
@@ -73,6 +823,37 @@ struct Scene
      */
     EntityID NewEntity();
 
+    /**
+     * @brief Create entities in bulk, each holding a copy of the components of a prefab
+     *
+     * The entities take consecutive fresh indices, so the free list is not used. Storage is grown
+     * once and every component column is filled in one pass, with memcpy for trivially copyable
+     * components.
+     *
+     * @param count Number of entities
+     * @param prefab Components copied into every entity
+     * @return EntityRange The created entities
+     */
+    EntityRange CreateEntities(size_t count, const Prefab &prefab);
+
+    /**
+     * @brief Destroy entities in bulk
+     *
+     * Stale and repeated ids are ignored. When a large part of a component pool or query goes
+     * away it is compacted in a single pass instead of erasing entity by entity.
+     *
+     * @param ids Entity IDs
+     * @param count Number of ids
+     */
+    void DestroyEntities(const EntityID *ids, size_t count);
+
+    /**
+     * @brief Destroy a range of entities created by CreateEntities
+     *
+     * @param range Entity range
+     */
+    void DestroyEntities(const EntityRange &range);
+
     /**
      * @brief Assign a component to an entity
      *
@@ -84,14 +865,91 @@ struct Scene
     T *Assign(EntityID id);
 
     /**
-     * @brief Get the component object from an entity
+     * @brief Get the component object from an entity for reading
+     *
+     * A page shared with a fork is read in place, use GetMut to write.
+     *
+     * @tparam T Component
+     * @param id Entity ID
+     * @return const T* Pointer to the component
+     */
+    template <typename T>
+    const T *Get(EntityID id);
+
+    /**
+     * @brief Get a component for writing, marking it changed at the current tick
+     *
+     * A page shared with a fork is unshared first.
      *
      * @tparam T Component
      * @param id Entity ID
      * @return T* Pointer to the component
      */
     template <typename T>
-    T *Get(EntityID id);
+    T *GetMut(EntityID id);
+
+    /**
+     * @brief Mark the component of an entity changed at the current tick
+     *
+     * @tparam T Component
+     * @param id Entity ID
+     */
+    template <typename T>
+    void MarkChanged(EntityID id);
+
+    /**
+     * @brief Get a handle to a shared component value, storing the value if no equal one is shared
+     *
+     * @tparam T Shared component
+     * @param value Component value
+     * @return Shared<T>
+     */
+    template <typename T>
+    Shared<T> Share(const T &value);
+
+    /**
+     * @brief Assign a shared component to an entity, reusing an equal value if one is shared
+     *
+     * @tparam T Shared component
+     * @param id Entity ID
+     * @param value Component value
+     * @return const T* The shared value, nullptr if the entity is stale
+     */
+    template <typename T>
+    const T *AssignShared(EntityID id, const T &value);
+
+    /**
+     * @brief Get the shared component value of an entity
+     *
+     * @tparam T Shared component
+     * @param id Entity ID
+     * @return const T* nullptr if the entity does not have the component
+     */
+    template <typename T>
+    const T *GetShared(EntityID id);
+
+    /**
+     * @brief Get the store of the values of a shared component, creating it on first use
+     *
+     * @tparam T Shared component
+     * @return SharedStore<T>&
+     */
+    template <typename T>
+    SharedStore<T> &GetSharedStore();
+
+    /**
+     * @brief Start a change detection pass
+     *
+     * Changes made before the call are stamped with a tick at most the returned value, changes made
+     * after it with a greater one. A system keeps the value and passes it to the next views it
+     * builds with Changed<T> or Added<T> to see what was touched in between.
+     *
+     * @return Tick The tick closing the pass
+     */
+    Tick AdvanceTick()
+    {
+        return changeTick++;
+    }
 
     /**
      * @brief Remove a component from an entity
@@ -109,6 +967,119 @@ struct Scene
      */
     void DestroyEntity(EntityID id);
 
+    /**
+     * @brief Attach an entity to a parent, keeping its current world position
+     *
+     * Both entities get a TransformComponent if they lack one. The child gets a ParentComponent and
+     * a LocalTransformComponent holding its offset from the parent, from which UpdateHierarchy
+     * derives its world transform.
+     *
+     * @param child Entity ID of the child
+     * @param parent Entity ID of the parent
+     * @return true if attached, false if an entity is stale or the parent is a descendant of the child
+     */
+    bool SetParent(EntityID child, EntityID parent);
+
+    /**
+     * @brief Detach an entity from its parent, keeping its current world position
+     *
+     * @param child Entity ID of the child
+     */
+    void ClearParent(EntityID child);
+
+    /**
+     * @brief Recompute the world transform of the entities whose parent moved or local transform changed
+     *
+     * Walks the hierarchy breadth first, so a subtree is only recomputed below a node that changed
+     * since the previous pass. Children of destroyed parents are detached, and removing the
+     * ParentComponent of an entity detaches it too. Must be called at a sync point.
+     */
+    void UpdateHierarchy();
+
+    /**
+     * @brief Bring the spatial index up to date with the transforms and bounds changed since the last call
+     *
+     * Only entities whose TransformComponent or BoundsComponent changed are moved; entries of
+     * destroyed entities and of entities that lost their transform are dropped. Queries on
+     * spatialIndex see the state of the last call. Must be called at a sync point.
+     */
+    void UpdateSpatialIndex();
+
+    /**
+     * @brief Run one step of the pass keeping storage in Morton (Z) order of the entity positions
+     *
+     * Each call sorts one storage, cycling through them, so the cost is spread over several
+     * frames: with sparse sets a component pool or a query's entity list, with archetype storage
+     * an archetype's rows. Pools and query lists sorted by the same key make view iteration walk
+     * the pools sequentially in screen order. Entities without transform keep their order at the
+     * end. Must be called at a sync point.
+     *
+     * Sorting moves components within their storage, so component pointers taken before the call,
+     * including the references handed to Python and the editor, must be fetched again afterwards.
+     * Clear m_spatialSort to keep them valid across frames.
+     */
+    void SpatialSortStep();
+
+    /**
+     * @brief Get the command buffer of the calling thread, creating it on first use
+     *
+     * @return CommandBuffer&
+     */
+    CommandBuffer &GetCommandBuffer();
+
+    /**
+     * @brief Apply the commands recorded in every command buffer, then clear the buffers
+     *
+     * Spawns are resolved first. The remaining commands are sorted by entity, keeping the order in
+     * which they were recorded, and the assigns and removes of an entity are merged so it changes
+     * storage once. Commands on entities that are stale by then are dropped. Must be called at a
+     * sync point, while no thread records commands or iterates a view.
+     */
+    void FlushCommands();
+
+    /**
+     * @brief Subscribe to the entities gaining component T, reassigning it counts as gaining it
+     *
+     * Handlers are called with one batch per sync point (FlushCommands), never from inside Assign.
+     * Only components added after subscribing are reported. By the time the batch is dispatched the
+     * component has been filled in by the code that assigned it.
+     *
+     * @tparam T Component
+     * @param handler Called with the scene and the entities of the batch
+     */
+    template <typename T>
+    void OnAdd(typename ComponentObserver<T>::Handler handler);
+
+    /**
+     * @brief Subscribe to the entities whose component T changed, through GetMut, MarkChanged or a Mut<T> view
+     *
+     * Components added in the same batch are only reported to OnAdd.
+     *
+     * @tparam T Component
+     * @param handler Called with the scene and the entities of the batch
+     */
+    template <typename T>
+    void OnSet(typename ComponentObserver<T>::Handler handler);
+
+    /**
+     * @brief Subscribe to the entities losing component T, through Remove, DestroyEntity or a command
+     *
+     * The removed value is copied into the batch before it is destroyed. Components torn down by
+     * UnloadLevel are not reported.
+     *
+     * @tparam T Component
+     * @param handler Called with the scene, the ids the entities had and the removed values
+     */
+    template <typename T>
+    void OnRemove(typename ComponentObserver<T>::RemoveHandler handler);
+
+    /**
+     * @brief Dispatch the batched events to the observers, called at the end of FlushCommands
+     *
+     * Handlers may change the scene; what they change is reported by the next dispatch.
+     */
+    void DispatchObservers();
+
     /**
      * @brief Create a new SpriteSheet entity
      *
@@ -119,6 +1090,16 @@ struct Scene
      */
     void CreateSpriteSheetTile(int x, int y, b2World *physicsWorld, Board *board);
 
+    /**
+     * @brief Create the entities of every tile of an imported level in one bulk operation
+     *
+     * @param tiles Tile id of each board cell, -1 for empty cells
+     * @param physicsWorld
+     * @param board
+     * @return EntityRange The tile entities, in board order
+     */
+    EntityRange CreateSpriteSheetTiles(const std::vector<int> &tiles, b2World *physicsWorld, Board *board);
+
     /**
      * @brief Add a Box2D collider to an entity
      *
@@ -130,8 +1111,157 @@ struct Scene
      */
     void AddBox2DCollider(EntityID entityID, bool isStatic, bool isTrigger, float x, float y, float width, float height, b2World *physicsWorld);
 
+    /**
+     * @brief Create the Box2D body of an entity from its Box2DBodyDescComponent, then remove the description
+     *
+     * @param entityID Entity with a Box2DColliderComponent and a Box2DBodyDescComponent
+     * @param physicsWorld
+     */
+    void CreateBox2DBody(EntityID entityID, b2World *physicsWorld);
+
+    /**
+     * @brief Create the Box2D bodies of every entity with a Box2DBodyDescComponent
+     *
+     * @param physicsWorld
+     */
+    void CreateBox2DBodies(b2World *physicsWorld);
+
+    /**
+     * @brief Get the compile time id of a registered component
+     *
+     * @tparam T Component
+     * @return int Component id
+     */
     template <class T>
-    int GetId();
+    static constexpr int GetId()
+    {
+        return ComponentTraits<T>::ID;
+    }
+
+#ifdef ECS_ARCHETYPE_STORAGE
+    /**
+     * @brief Find the archetype storing exactly the components in mask, creating it if needed
+     *
+     * @param mask Component mask
+     * @return Archetype*
+     */
+    Archetype *GetArchetype(const ComponentMask &mask);
+
+    /**
+     * @brief Follow the archetype graph from an archetype by adding or removing a component
+     *
+     * @param archetype Source archetype
+     * @param componentId Component to add or remove
+     * @param add Add the component if true, remove it otherwise
+     * @return Archetype*
+     */
+    Archetype *GetArchetypeEdge(Archetype *archetype, int componentId, bool add);
+
+    /**
+     * @brief Move an entity's row into another archetype, relocating the components both share
+     *
+     * @param index Entity index
+     * @param target Destination archetype
+     */
+    void MoveEntity(EntityIndex index, Archetype *target);
+#endif
+
+    /**
+     * @brief Get the persistent query for an include/exclude mask pair, registering it on first use
+     *
+     * @param include Components an entity must have
+     * @param exclude Components an entity must not have
+     * @return SceneQuery* Query kept up to date by the scene
+     */
+    SceneQuery *GetQuery(const ComponentMask &include, const ComponentMask &exclude = ComponentMask());
+
+#ifndef ECS_ARCHETYPE_STORAGE
+    /**
+     * @brief Get the owning group of a set of components, registering it on first use
+     *
+     * Once registered, assigning an owned component may move the owned components of other
+     * entities within their pools.
+     *
+     * @param owned Components of the group
+     * @return OwningGroup* nullptr if one of the components is already owned by another group
+     */
+    OwningGroup *GetGroup(const ComponentMask &owned);
+
+    /**
+     * @brief Move an entity out of the groups it is about to leave, before its components are erased
+     *
+     * @param index Entity index
+     * @param removed Components the entity is losing
+     */
+    void LeaveGroups(EntityIndex index, const ComponentMask &removed);
+#endif
+
+    /**
+     * @brief Update the registered queries after an entity's mask or validity changed
+     *
+     * @param index Entity index
+     * @param previousMask Mask of the entity before the change
+     * @param wasValid Whether the entity was alive before the change
+     */
+    void RefreshQueries(EntityIndex index, const ComponentMask &previousMask, bool wasValid);
+
+    /**
+     * @brief Scan every entity mask and mark the valid entities having all components of include
+     * and none of exclude
+     *
+     * Uses AVX2 or SSE2 to test several entities per instruction when masks fit in one word.
+     *
+     * @param include Components an entity must have
+     * @param exclude Components an entity must not have
+     * @param bitmap Output with one bit per entity index
+     */
+    void MatchEntities(const ComponentMask &include, const ComponentMask &exclude, std::vector<uint64_t> &bitmap);
+
+    /**
+     * @brief Get the change ticks of a component of an entity
+     *
+     * @param index Entity index
+     * @param componentId Component the entity must have
+     * @return ComponentTicks&
+     */
+    ComponentTicks &TicksOf(EntityIndex index, int componentId);
+
+    /**
+     * @brief Get the observers of component T, creating them if needed
+     *
+     * @tparam T Component
+     * @return ComponentObserver<T>&
+     */
+    template <typename T>
+    ComponentObserver<T> &GetObserver();
+
+    /**
+     * @brief Copy the components an entity is about to lose into the queues of their observers
+     *
+     * @param index Entity index
+     * @param removed Components the entity is losing
+     */
+    void QueueRemoved(EntityIndex index, const ComponentMask &removed);
+
+    /**
+     * @brief List the entities whose component was added or changed after a tick
+     *
+     * @param componentId Component id
+     * @param since Tick of the previous batch
+     * @param added true for added components, false for changed components added at or before since
+     * @param result Output entity ids
+     */
+    void CollectTicked(int componentId, Tick since, bool added, std::vector<EntityID> &result);
+
+    /**
+     * @brief Apply the merged component commands of one entity
+     *
+     * @param index Entity index
+     * @param assigned Components to assign
+     * @param removed Components to remove
+     * @param assigns Assign command of each assigned component, indexed by component id
+     */
+    void ApplyComponentCommands(EntityIndex index, const ComponentMask &assigned, const ComponentMask &removed, Command *const *assigns);
 
     EntityID CreateEntityId(EntityIndex index, EntityVersion version);
     EntityIndex GetEntityIndex(EntityID id);
@@ -139,12 +1269,323 @@ struct Scene
     bool IsEntityValid(EntityID id);
 
     std::vector<EntityDesc> entities;
-    std::vector<ComponentPool *> componentPools;
+#ifdef ECS_ARCHETYPE_STORAGE
+    std::vector<EntityLocation> locations;
+    std::vector<Archetype *> archetypes;
+    std::unordered_map<ComponentMask, Archetype *> archetypeLookup;
+    std::vector<ComponentInfo> componentInfos;
+#else
+    std::array<ComponentPool *, COMPONENT_COUNT> componentPools{}; // One pool per registered component
+    std::vector<OwningGroup *> groups;
+    std::array<OwningGroup *, COMPONENT_COUNT> poolOwners{}; // Group owning each pool, if any
+#endif
+    std::array<ComponentObserverBase *, COMPONENT_COUNT> observers{}; // Indexed by component id, null when unobserved, not copied to forks
+    ComponentMask observedRemovals;                                  // Components whose removal is queued for OnRemove handlers
+    std::array<std::shared_ptr<SharedStoreBase>, COMPONENT_COUNT> sharedStores{}; // Indexed by the id of Shared<T>, shared with forks
     std::vector<EntityIndex> freeEntities;
+    TransformHierarchy hierarchy; // Parent links of the entities with a ParentComponent
+    SpatialHash spatialIndex;     // Bounds of the entities with a TransformComponent
+    std::vector<uint32_t> mortonKeys; // Scratch of SpatialSortStep, Morton code of each position of the storage being sorted
+    size_t spatialSortCursor{0};      // Storage sorted by the next SpatialSortStep
+    std::vector<SceneQuery *> queries;
+    std::unordered_map<QueryKey, SceneQuery *> queryLookup;
+    Tick changeTick{1}; // Tick stamped on assigned and changed components
+
+    MonotonicArena arena;            // Level lifetime data such as sprite sheets, released by UnloadLevel
+    JobSystem *jobSystem{nullptr};   // Workers running SceneView::par_each, which runs serially without one
+    PhysicsThread *physics{nullptr}; // Steps the world the bodies live in, not copied to forks
+    std::unique_ptr<b2World> ownedWorld; // World of a fork made by ForkWithPhysics, destroyed with the scene
+
+    std::vector<CommandBuffer *> commandBuffers; // Flushed in creation order
+    std::unordered_map<std::thread::id, CommandBuffer *> threadCommandBuffers;
+    std::mutex commandMutex;
+    std::mutex queryMutex; // Guards query and group registration, systems may build views concurrently
 
     // toggles
     bool m_showGrid = true;
     bool m_showColliders = true;
+    bool m_spatialSort = true; // Keep storage in Morton order of the positions
+    bool m_serialSystems = false; // Run the systems one at a time and their parallel loops on the main thread, for debugging
 
     EntityID m_selectedEntity = -1;
 };
+
+inline EntityID Scene::CreateEntityId(EntityIndex index, EntityVersion version)
+{
+    // Shift the index up 32, and put the version in the bottom
+    return ((EntityID)index << 32) | ((EntityID)version);
+}
+
+inline EntityIndex Scene::GetEntityIndex(EntityID id)
+{
+    // Shift down 32 so we lose the version and get our index
+    return id >> 32;
+}
+
+inline EntityVersion Scene::GetEntityVersion(EntityID id)
+{
+    // Cast to a 32 bit int to get our version number (loosing the top 32 bits)
+    return (EntityVersion)id;
+}
+
+inline bool Scene::IsEntityValid(EntityID id)
+{
+    // Check if the index is our invalid index
+    return (id >> 32) != EntityIndex(-1);
+}
+
+inline ComponentTicks &Scene::TicksOf(EntityIndex index, int componentId)
+{
+#ifdef ECS_ARCHETYPE_STORAGE
+    const EntityLocation &location = locations[index];
+    return location.archetype->Ticks(location.row, location.archetype->ColumnOf(componentId));
+#else
+    return componentPools[componentId]->ticksOf(index);
+#endif
+}
+
+template <typename T>
+T *Scene::Assign(EntityID id)
+{
+    if (entities[GetEntityIndex(id)].id != id)
+        return nullptr;
+    constexpr int componentId = ComponentTraits<T>::ID;
+    EntityIndex index = GetEntityIndex(id);
+    bool hadComponent = entities.at(index).mask.test(componentId);
+
+#ifdef ECS_ARCHETYPE_STORAGE
+    // Move the entity to the archetype with the new component
+    if (!hadComponent)
+    {
+        MoveEntity(index, GetArchetypeEdge(locations.at(index).archetype, componentId, true));
+    }
+
+    // Initialize the component in its column with placement new
+    const EntityLocation &location = locations.at(index);
+    void *pMemory = location.archetype->Get(location.row, location.archetype->ColumnOf(componentId));
+#else
+    // Reserve a slot in the pool, and initialize the component with placement new
+    void *pMemory = componentPools[componentId]->emplace(index);
+#endif
+    if (hadComponent)
+    {
+        // Reassigning replaces the existing component
+        static_cast<T *>(pMemory)->~T();
+    }
+    T *pComponent = new (pMemory) T();
+    TicksOf(index, componentId) = {changeTick, changeTick};
+
+    // Set the bit for this component to true and return the created component
+    ComponentMask previousMask = entities.at(index).mask;
+    entities.at(index).mask.set(componentId);
+    if (previousMask != entities.at(index).mask)
+    {
+        RefreshQueries(index, previousMask, true);
+#ifndef ECS_ARCHETYPE_STORAGE
+        // Entering an owning group moves the component within its pool
+        pComponent = static_cast<T *>(componentPools[componentId]->get(index));
+#endif
+    }
+    return pComponent;
+}
+
+template <typename T>
+const T *Scene::Get(EntityID id)
+{
+    if (entities[GetEntityIndex(id)].id != id)
+        return nullptr;
+
+    constexpr int componentId = ComponentTraits<T>::ID;
+
+    if (!entities.at(GetEntityIndex(id)).mask.test(componentId))
+        return nullptr;
+
+#ifdef ECS_ARCHETYPE_STORAGE
+    const EntityLocation &location = locations.at(GetEntityIndex(id));
+    const T *pComponent = static_cast<const T *>(location.archetype->Get(location.row, location.archetype->ColumnOf(componentId)));
+#else
+    const T *pComponent = static_cast<const T *>(componentPools[componentId]->read(GetEntityIndex(id)));
+#endif
+
+    // Log the entity id, entity index, and the component id
+    // std::cout << "Entity ID: " << id << " Entity Index: " << GetEntityIndex(id) << " Component ID: " << componentId << std::endl;
+    return pComponent;
+}
+
+template <typename T>
+T *Scene::GetMut(EntityID id)
+{
+    if (Get<T>(id) == nullptr)
+        return nullptr;
+
+    constexpr int componentId = ComponentTraits<T>::ID;
+#ifdef ECS_ARCHETYPE_STORAGE
+    const EntityLocation &location = locations[GetEntityIndex(id)];
+    T *pComponent = static_cast<T *>(location.archetype->Get(location.row, location.archetype->ColumnOf(componentId)));
+#else
+    T *pComponent = static_cast<T *>(componentPools[componentId]->get(GetEntityIndex(id)));
+#endif
+    TicksOf(GetEntityIndex(id), componentId).changed = changeTick;
+    return pComponent;
+}
+
+template <typename T>
+void Scene::MarkChanged(EntityID id)
+{
+    if (entities.at(GetEntityIndex(id)).id != id || !entities.at(GetEntityIndex(id)).mask.test(ComponentTraits<T>::ID))
+        return;
+    TicksOf(GetEntityIndex(id), ComponentTraits<T>::ID).changed = changeTick;
+}
+
+template <typename T>
+SharedStore<T> &Scene::GetSharedStore()
+{
+    constexpr int componentId = ComponentTraits<Shared<T>>::ID;
+    if (sharedStores[componentId] == nullptr)
+    {
+        sharedStores[componentId] = std::make_shared<SharedStore<T>>();
+    }
+    return *static_cast<SharedStore<T> *>(sharedStores[componentId].get());
+}
+
+template <typename T>
+Shared<T> Scene::Share(const T &value)
+{
+    return GetSharedStore<T>().Intern(value);
+}
+
+template <typename T>
+const T *Scene::AssignShared(EntityID id, const T &value)
+{
+    Shared<T> *pHandle = Assign<Shared<T>>(id);
+    if (pHandle == nullptr)
+        return nullptr;
+    *pHandle = Share(value);
+    return pHandle->get();
+}
+
+template <typename T>
+const T *Scene::GetShared(EntityID id)
+{
+    const Shared<T> *pHandle = Get<Shared<T>>(id);
+    return pHandle ? pHandle->get() : nullptr;
+}
+
+template <typename T>
+void Scene::Remove(EntityID id)
+{
+    // ensures you're not accessing an entity that has been deleted
+    if (entities.at(GetEntityIndex(id)).id != id)
+        return;
+
+    constexpr int componentId = ComponentTraits<T>::ID;
+    if (!entities.at(GetEntityIndex(id)).mask.test(componentId))
+        return;
+
+    ComponentMask removed;
+    removed.set(componentId);
+    QueueRemoved(GetEntityIndex(id), removed);
+
+#ifdef ECS_ARCHETYPE_STORAGE
+    MoveEntity(GetEntityIndex(id), GetArchetypeEdge(locations.at(GetEntityIndex(id)).archetype, componentId, false));
+#else
+    LeaveGroups(GetEntityIndex(id), removed);
+    componentPools[componentId]->erase(GetEntityIndex(id));
+#endif
+    ComponentMask previousMask = entities.at(GetEntityIndex(id)).mask;
+    entities.at(GetEntityIndex(id)).mask.reset(componentId);
+    RefreshQueries(GetEntityIndex(id), previousMask, true);
+}
+
+inline void Scene::QueueRemoved(EntityIndex index, const ComponentMask &removed)
+{
+    // Unobserved components cost a single mask test
+    if (!removed.intersects(observedRemovals))
+        return;
+
+    ComponentMask queued = removed & observedRemovals;
+    for (size_t componentId = 0; componentId < COMPONENT_COUNT; componentId++)
+    {
+        if (!queued.test(componentId))
+            continue;
+#ifdef ECS_ARCHETYPE_STORAGE
+        const EntityLocation &location = locations[index];
+        const void *pComponent = location.archetype->Get(location.row, location.archetype->ColumnOf(int(componentId)));
+#else
+        const void *pComponent = componentPools[componentId]->read(index);
+#endif
+        observers[componentId]->queueRemoved(observers[componentId], entities[index].id, pComponent);
+    }
+}
+
+template <typename T>
+ComponentObserver<T> &Scene::GetObserver()
+{
+    constexpr int componentId = ComponentTraits<T>::ID;
+    if (observers[componentId] == nullptr)
+    {
+        observers[componentId] = new ComponentObserver<T>();
+        // Components touched before subscribing are not reported
+        observers[componentId]->since = AdvanceTick();
+    }
+    return *static_cast<ComponentObserver<T> *>(observers[componentId]);
+}
+
+template <typename T>
+void Scene::OnAdd(typename ComponentObserver<T>::Handler handler)
+{
+    GetObserver<T>().onAdd.push_back(std::move(handler));
+}
+
+template <typename T>
+void Scene::OnSet(typename ComponentObserver<T>::Handler handler)
+{
+    GetObserver<T>().onSet.push_back(std::move(handler));
+}
+
+template <typename T>
+void Scene::OnRemove(typename ComponentObserver<T>::RemoveHandler handler)
+{
+    GetObserver<T>().onRemove.push_back(std::move(handler));
+    observedRemovals.set(ComponentTraits<T>::ID);
+}
+
+template <typename T>
+void ComponentObserver<T>::Dispatch(Scene &scene, Tick closing)
+{
+    constexpr int componentId = ComponentTraits<T>::ID;
+    Tick previous = since;
+    since = closing;
+
+    // Handlers are indexed since they may subscribe more handlers
+    std::vector<EntityID> batch;
+    if (!onAdd.empty())
+    {
+        scene.CollectTicked(componentId, previous, true, batch);
+        for (size_t handler = 0; handler < onAdd.size() && !batch.empty(); handler++)
+        {
+            onAdd[handler](scene, batch);
+        }
+    }
+    if (!onSet.empty())
+    {
+        batch.clear();
+        scene.CollectTicked(componentId, previous, false, batch);
+        for (size_t handler = 0; handler < onSet.size() && !batch.empty(); handler++)
+        {
+            onSet[handler](scene, batch);
+        }
+    }
+    if (!removedIds.empty())
+    {
+        // Removals made by the handlers are queued for the next dispatch
+        std::vector<EntityID> ids;
+        std::vector<T> values;
+        ids.swap(removedIds);
+        values.swap(removed);
+        for (size_t handler = 0; handler < onRemove.size(); handler++)
+        {
+            onRemove[handler](scene, ids, values);
+        }
+    }
+}
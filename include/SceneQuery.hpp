@@ -0,0 +1,139 @@
+#pragma once
+
+#include <vector>
+#include "Archetype.hpp"
+#include "Constants.hpp"
+
+/**
+ * @brief Include and exclude masks identifying a query
+ *
+ */
+struct QueryKey
+{
+    ComponentMask include;
+    ComponentMask exclude;
+
+    bool operator==(const QueryKey &other) const
+    {
+        return include == other.include && exclude == other.exclude;
+    }
+};
+
+namespace std
+{
+    template <>
+    struct hash<QueryKey>
+    {
+        size_t operator()(const QueryKey &key) const
+        {
+            size_t seed = std::hash<ComponentMask>()(key.include);
+            return seed ^ (std::hash<ComponentMask>()(key.exclude) + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+        }
+    };
+}
+
+/**
+ * @brief Persistent query result registered with a Scene
+ *
+ * Keeps the entities matching an include/exclude mask pair packed in a list. The scene updates the
+ * list whenever an entity's mask changes, so iterating costs only the number of matches.
+ */
+struct SceneQuery
+{
+    /**
+     * @brief Construct a new Scene Query object
+     *
+     * @param includeMask Components a matching entity must have
+     * @param excludeMask Components a matching entity must not have
+     */
+    SceneQuery(const ComponentMask &includeMask, const ComponentMask &excludeMask)
+        : include(includeMask), exclude(excludeMask) {}
+
+    /**
+     * @brief Check if an entity mask matches the query
+     *
+     * @param mask Entity component mask
+     * @return true if the mask has every included and none of the excluded components
+     */
+    inline bool Matches(const ComponentMask &mask) const
+    {
+        return mask.contains(include) && !mask.intersects(exclude);
+    }
+
+    /**
+     * @brief Add a matching entity to the packed list
+     *
+     * @param index Entity index
+     */
+    void Add(EntityIndex index)
+    {
+        if (positions.size() <= index)
+        {
+            positions.resize(index + 1, EntityIndex(-1));
+        }
+        positions[index] = EntityIndex(entities.size());
+        entities.push_back(index);
+    }
+
+    /**
+     * @brief Add a run of consecutive matching entity indices
+     *
+     * @param first First entity index
+     * @param count Number of entities
+     */
+    void AddRange(EntityIndex first, size_t count)
+    {
+        if (positions.size() < first + count)
+        {
+            positions.resize(first + count, EntityIndex(-1));
+        }
+        entities.reserve(entities.size() + count);
+        for (size_t i = 0; i < count; i++)
+        {
+            positions[first + i] = EntityIndex(entities.size());
+            entities.push_back(first + EntityIndex(i));
+        }
+    }
+
+    /**
+     * @brief Remove every marked entity from the packed list in one compacting pass
+     *
+     * @param marked Bitmap with one bit per entity index
+     */
+    void RemoveMarked(const std::vector<uint64_t> &marked)
+    {
+        size_t kept = 0;
+        for (size_t position = 0; position < entities.size(); position++)
+        {
+            EntityIndex index = entities[position];
+            if ((marked[index / 64] >> (index % 64)) & 1)
+            {
+                positions[index] = EntityIndex(-1);
+                continue;
+            }
+            entities[kept] = index;
+            positions[index] = EntityIndex(kept++);
+        }
+        entities.resize(kept);
+    }
+
+    /**
+     * @brief Remove an entity from the packed list, moving the last entity into its place
+     *
+     * @param index Entity index
+     */
+    void Remove(EntityIndex index)
+    {
+        EntityIndex position = positions[index];
+        entities[position] = entities.back();
+        positions[entities[position]] = position;
+        entities.pop_back();
+        positions[index] = EntityIndex(-1);
+    }
+
+    ComponentMask include;
+    ComponentMask exclude;
+    std::vector<EntityIndex> entities;  // Packed indices of the matching entities
+    std::vector<EntityIndex> positions; // Position of each entity index in the packed list
+    std::vector<Archetype *> archetypes; // Matching archetypes when using archetype storage
+};
@@ -1,13 +1,84 @@
 #pragma once
 
 #include <iostream>
+#include <algorithm>
 #include <vector>
+#include <tuple>
+#include <utility>
 #include "Scene.hpp"
+#include "QueryFilters.hpp"
+#include "JobSystem.hpp"
+
+/**
+ * @brief Number of elements per chunk of a parallel loop
+ *
+ * Chunks hold a multiple of 64 elements, so when the chunks cut an array aligned on a cache line in
+ * index order every chunk starts on a cache line whatever the element size, and neighbouring jobs
+ * never write the same line. Pool pages, archetype columns and tick vectors are all aligned that
+ * way; par_each cuts them in storage order.
+ *
+ * @param grain Requested elements per chunk
+ * @return size_t
+ */
+inline size_t ParallelChunkSize(size_t grain)
+{
+    return (std::max<size_t>(grain, 1) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+}
+
+/**
+ * @brief Run fn(chunk) for every chunk index on the job system of a scene
+ *
+ * The calling thread runs the first chunk and helps with the others until all are done. Without a
+ * job system, with a single chunk, or while the scene's systems run serially for debugging,
+ * everything runs on the calling thread.
+ *
+ * @tparam Fn void(size_t chunk)
+ * @param pScene Scene whose job system runs the chunks
+ * @param chunkCount Number of chunks
+ * @param fn Called once per chunk, concurrently
+ */
+template <typename Fn>
+void ParallelChunks(Scene *pScene, size_t chunkCount, Fn &fn)
+{
+    JobSystem *pJobs = pScene->jobSystem;
+    if (pJobs == nullptr || pJobs->WorkerCount() == 0 || pScene->m_serialSystems || chunkCount <= 1)
+    {
+        for (size_t chunk = 0; chunk < chunkCount; chunk++)
+        {
+            fn(chunk);
+        }
+        return;
+    }
+
+    JobCounter counter;
+    for (size_t chunk = 1; chunk < chunkCount; chunk++)
+    {
+        pJobs->Submit([&fn, chunk]
+                      { fn(chunk); },
+                      counter);
+    }
+    fn(0);
+    pJobs->Wait(counter);
+}
 
 /**
  * @brief Iterator for Entites of the scene
  *
- * @tparam ComponentTypes
+ * Views are backed by a persistent SceneQuery registered with the scene, which keeps the
+ * matching entities packed and is updated as components are assigned and removed. Building a
+ * view is a lookup and iterating it only touches the matching entities. With archetype storage
+ * the query holds the matching archetypes and the view walks their rows.
+ *
+ * Besides plain components the view accepts the filters Without<T>, Optional<T> and With<T>. They
+ * are compiled into the include/exclude masks of the query, so entities rejected by a filter are
+ * dropped by the mask scan and never dereferenced. each() fetches plain components by const
+ * reference and optional ones by const pointer; Without and With terms add nothing to the tuple.
+ *
+ * Changed<T> and Added<T> additionally compare the change ticks of T with the tick the view was
+ * built with, skipping entities untouched since then. Mut<T> fetches T by reference for writing
+ * and stamps it changed. Only Mut<T> copies a page shared with a fork.
+ *
+ * @tparam ComponentTypes Components and filters
  */
 template <typename... ComponentTypes>
 struct SceneView
@@ -16,8 +87,9 @@ struct SceneView
      * @brief Construct a new Scene View object
      *
      * @param scene Scene
+     * @param sinceTick Tick Changed<T> and Added<T> compare against, usually from Scene::AdvanceTick
      */
-    SceneView(Scene &scene) : pScene(&scene)
+    SceneView(Scene &scene, Tick sinceTick = 0) : pScene(&scene), since(sinceTick)
     {
         if (sizeof...(ComponentTypes) == 0)
         {
@@ -25,78 +97,883 @@ struct SceneView
         }
         else
         {
-            // Unpack the template parameters into an initializer list
-            int componentIds[] = {0, scene.GetId<ComponentTypes>()...};
+            // Unpack the template parameters into initializer lists
+            int componentIds[] = {0, Scene::GetId<typename QueryTerm<ComponentTypes>::Component>()...};
+            bool included[] = {false, QueryTerm<ComponentTypes>::INCLUDE...};
+            bool excluded[] = {false, QueryTerm<ComponentTypes>::EXCLUDE...};
             for (size_t i = 1; i < (sizeof...(ComponentTypes) + 1); i++)
-                componentMask.set(componentIds[i]);
+            {
+                if (included[i])
+                    componentMask.set(componentIds[i]);
+                if (excluded[i])
+                    excludeMask.set(componentIds[i]);
+            }
         }
+        pQuery = scene.GetQuery(componentMask, excludeMask);
     }
 
     /**
-     * @brief Iterator for the SceneView
+     * @brief Tuple yielded by each(): the entity followed by the fetched part of every term
+     *
+     */
+    typedef decltype(std::tuple_cat(std::declval<std::tuple<EntityID>>(), std::declval<typename QueryTerm<ComponentTypes>::Fetched>()...)) Item;
+
+    // Whether any term tests change ticks, otherwise every entity of the query is accepted
+    static constexpr bool TICK_FILTERED = (false || ... || (QueryTerm<ComponentTypes>::TICK != TickFilter::NONE));
+
+    /**
+     * @brief Check the change ticks of a component against the tick of the view
+     *
+     * @tparam Term QueryTerm with a tick filter
+     * @param ticks Change ticks of the component
+     * @param since Tick of the view
+     * @return true if the component was added or changed after since
+     */
+    template <typename Term>
+    static bool Newer(const ComponentTicks &ticks, Tick since)
+    {
+        return (Term::TICK == TickFilter::ADDED ? ticks.added : ticks.changed) > since;
+    }
+
+#ifdef ECS_ARCHETYPE_STORAGE
+    /**
+     * @brief Check the tick filters of every term for a row
+     *
+     * @param pArchetype Archetype
+     * @param row Row index
+     * @param since Tick of the view
+     * @return true if every Changed and Added term passes
+     */
+    static bool Accept(Archetype *pArchetype, size_t row, Tick since)
+    {
+        return (true && ... && AcceptTerm<QueryTerm<ComponentTypes>>(pArchetype, row, since));
+    }
+
+    template <typename Term>
+    static bool AcceptTerm(Archetype *pArchetype, size_t row, Tick since)
+    {
+        if constexpr (Term::TICK == TickFilter::NONE)
+        {
+            return true;
+        }
+        else
+        {
+            return Newer<Term>(pArchetype->Ticks(row, pArchetype->ColumnOf(Scene::GetId<typename Term::Component>())), since);
+        }
+    }
+
+    /**
+     * @brief Iterator for the SceneView, walking the rows of every matching archetype
      *
      */
     struct Iterator
     {
-        Iterator(Scene *pScene, EntityIndex index, ComponentMask mask, bool all)
-            : index(index), pScene(pScene), mask(mask), all(all) {}
+        Iterator(Scene *pScene, const std::vector<Archetype *> *pArchetypes, size_t archetype, Tick since)
+            : archetype(archetype), pScene(pScene), pArchetypes(pArchetypes), since(since)
+        {
+            SkipEmpty();
+        }
 
         EntityID operator*() const
         {
-            return pScene->entities[index].id;
+            return pScene->entities[(*pArchetypes)[archetype]->EntityAt(row)].id;
         }
 
         bool operator==(const Iterator &other) const
         {
-            return index == other.index || index == pScene->entities.size();
+            return archetype == other.archetype && row == other.row;
         }
 
         bool operator!=(const Iterator &other) const
         {
-            return index != other.index && index != pScene->entities.size();
+            return !(*this == other);
         }
 
-        bool ValidIndex()
+        Iterator &operator++()
         {
-            return
-                // It's a valid entity ID
-                pScene->IsEntityValid(pScene->entities[index].id) &&
-                // It has the correct component mask
-                (all || mask == (mask & pScene->entities[index].mask));
+            row++;
+            SkipEmpty();
+            return *this;
         }
 
-        Iterator &operator++()
+        /**
+         * @brief Move to the next existing row accepted by the tick filters
+         *
+         */
+        void SkipEmpty()
         {
-            do
+            while (archetype < pArchetypes->size())
             {
-                index++;
-            } while (index < pScene->entities.size() && !ValidIndex());
-            return *this;
+                Archetype *pArchetype = (*pArchetypes)[archetype];
+                if (row >= pArchetype->count)
+                {
+                    archetype++;
+                    row = 0;
+                }
+                else if (Accept(pArchetype, row, since))
+                {
+                    break;
+                }
+                else
+                {
+                    row++;
+                }
+            }
         }
 
-        EntityIndex index;
+        size_t archetype;
+        size_t row{0};
         Scene *pScene;
-        ComponentMask mask;
-        bool all{false};
+        const std::vector<Archetype *> *pArchetypes;
+        Tick since;
     };
 
     const Iterator begin() const
     {
-        size_t firstIndex = 0;
-        while (firstIndex < pScene->entities.size() &&
-               (componentMask != (componentMask & pScene->entities[firstIndex].mask) || !pScene->IsEntityValid(pScene->entities[firstIndex].id)))
+        return Iterator(pScene, &pQuery->archetypes, 0, since);
+    }
+
+    const Iterator end() const
+    {
+        return Iterator(pScene, &pQuery->archetypes, pQuery->archetypes.size(), since);
+    }
+
+    /**
+     * @brief Iterator yielding the entity and its fetched components
+     *
+     * Column indices are resolved once per archetype and column pointers once per chunk, so each
+     * step is a strided load from every column. Optional components missing from an archetype get
+     * a null column.
+     */
+    struct EachIterator
+    {
+        EachIterator(Scene *pScene, const std::vector<Archetype *> *pArchetypes, size_t archetype, Tick since, size_t row = 0)
+            : archetype(archetype), row(row), pScene(pScene), pArchetypes(pArchetypes), since(since)
         {
-            firstIndex++;
+            SkipEmpty();
         }
-        return Iterator(pScene, firstIndex, componentMask, all);
+
+        Item operator*() const
+        {
+            return Fetch(std::index_sequence_for<ComponentTypes...>());
+        }
+
+        bool operator!=(const EachIterator &other) const
+        {
+            return archetype != other.archetype || row != other.row;
+        }
+
+        EachIterator &operator++()
+        {
+            row++;
+            slot++;
+            Archetype *pArchetype = (*pArchetypes)[archetype];
+            if (slot == pArchetype->chunkCapacity || row >= pArchetype->count || !Accept(pArchetype, row, since))
+            {
+                SkipEmpty();
+            }
+            return *this;
+        }
+
+        /**
+         * @brief Move to the next existing row accepted by the tick filters, resolving its chunk
+         *
+         */
+        void SkipEmpty()
+        {
+            while (archetype < pArchetypes->size())
+            {
+                Archetype *pArchetype = (*pArchetypes)[archetype];
+                if (row >= pArchetype->count)
+                {
+                    archetype++;
+                    row = 0;
+                }
+                else if (Accept(pArchetype, row, since))
+                {
+                    ResolveChunk(std::index_sequence_for<ComponentTypes...>());
+                    break;
+                }
+                else
+                {
+                    row++;
+                }
+            }
+        }
+
+        template <size_t... I>
+        void ResolveChunk(std::index_sequence<I...>)
+        {
+            const Archetype *pArchetype = (*pArchetypes)[archetype];
+            size_t chunk = row / pArchetype->chunkCapacity;
+            slot = row % pArchetype->chunkCapacity;
+            pEntities = pArchetype->Entities(chunk);
+            ((columnIndices[I] = QueryTerm<ComponentTypes>::FETCH ? pArchetype->ColumnOf(Scene::GetId<typename QueryTerm<ComponentTypes>::Component>()) : -1), ...);
+            ((columns[I] = columnIndices[I] == -1 ? nullptr : static_cast<char *>(pArchetype->Column(chunk, columnIndices[I]))), ...);
+        }
+
+        template <typename Term>
+        void *Component(size_t term) const
+        {
+            if constexpr (Term::FETCH)
+            {
+                if (columns[term] == nullptr)
+                {
+                    return nullptr;
+                }
+                if constexpr (Term::MARK)
+                {
+                    (*pArchetypes)[archetype]->Ticks(row, columnIndices[term]).changed = pScene->changeTick;
+                }
+                return columns[term] + slot * sizeof(typename Term::Component);
+            }
+            else
+            {
+                return nullptr;
+            }
+        }
+
+        template <size_t... I>
+        Item Fetch(std::index_sequence<I...>) const
+        {
+            return std::tuple_cat(std::tuple<EntityID>(pScene->entities[pEntities[slot]].id), QueryTerm<ComponentTypes>::Fetch(Component<QueryTerm<ComponentTypes>>(I))...);
+        }
+
+        size_t archetype;
+        size_t row{0};
+        size_t slot{0};
+        Scene *pScene;
+        const std::vector<Archetype *> *pArchetypes;
+        Tick since;
+        const EntityIndex *pEntities{nullptr};
+        char *columns[sizeof...(ComponentTypes) + 1]{};
+        int columnIndices[sizeof...(ComponentTypes) + 1]{};
+    };
+
+    /**
+     * @brief Range over the view yielding Item tuples
+     *
+     */
+    struct EachRange
+    {
+        EachIterator begin() const
+        {
+            return EachIterator(pScene, &pQuery->archetypes, 0, since);
+        }
+
+        EachIterator end() const
+        {
+            return EachIterator(pScene, &pQuery->archetypes, pQuery->archetypes.size(), since);
+        }
+
+        Scene *pScene;
+        SceneQuery *pQuery;
+        Tick since;
+    };
+#else
+    /**
+     * @brief Check the tick filters of every term for an entity
+     *
+     * @param pScene Scene
+     * @param index Entity index
+     * @param since Tick of the view
+     * @return true if every Changed and Added term passes
+     */
+    static bool Accept(Scene *pScene, EntityIndex index, Tick since)
+    {
+        return (true && ... && AcceptTerm<QueryTerm<ComponentTypes>>(pScene, index, since));
+    }
+
+    template <typename Term>
+    static bool AcceptTerm(Scene *pScene, EntityIndex index, Tick since)
+    {
+        if constexpr (Term::TICK == TickFilter::NONE)
+        {
+            return true;
+        }
+        else
+        {
+            return Newer<Term>(pScene->componentPools[Scene::GetId<typename Term::Component>()]->ticksOf(index), since);
+        }
+    }
+
+    /**
+     * @brief Iterator for the SceneView, walking the packed entities of the query
+     *
+     */
+    struct Iterator
+    {
+        Iterator(Scene *pScene, const std::vector<EntityIndex> *pEntities, size_t position, Tick since)
+            : position(position), pScene(pScene), pEntities(pEntities), since(since)
+        {
+            SkipRejected();
+        }
+
+        EntityID operator*() const
+        {
+            return pScene->entities[(*pEntities)[position]].id;
+        }
+
+        bool operator==(const Iterator &other) const
+        {
+            return position == other.position;
+        }
+
+        bool operator!=(const Iterator &other) const
+        {
+            return position != other.position;
+        }
+
+        Iterator &operator++()
+        {
+            position++;
+            SkipRejected();
+            return *this;
+        }
+
+        /**
+         * @brief Move to the next entity accepted by the tick filters
+         *
+         */
+        void SkipRejected()
+        {
+            if constexpr (TICK_FILTERED)
+            {
+                while (position < pEntities->size() && !Accept(pScene, (*pEntities)[position], since))
+                {
+                    position++;
+                }
+            }
+        }
+
+        size_t position;
+        Scene *pScene;
+        const std::vector<EntityIndex> *pEntities;
+        Tick since;
+    };
+
+    const Iterator begin() const
+    {
+        return Iterator(pScene, &pQuery->entities, 0, since);
     }
 
     const Iterator end() const
     {
-        return Iterator(pScene, EntityIndex(pScene->entities.size()), componentMask, all);
+        return Iterator(pScene, &pQuery->entities, pQuery->entities.size(), since);
+    }
+
+    /**
+     * @brief Iterator yielding the entity and its fetched components
+     *
+     * The component pools are resolved once per view, each step only indexes into them. Optional
+     * components are the only ones checked for presence.
+     */
+    struct EachIterator
+    {
+        EachIterator(size_t position, Scene *pScene, const std::vector<EntityIndex> *pEntities, ComponentPool *const *pools, Tick since)
+            : position(position), pScene(pScene), pEntities(pEntities), pools(pools), since(since)
+        {
+            SkipRejected();
+        }
+
+        Item operator*() const
+        {
+            return Fetch((*pEntities)[position], std::index_sequence_for<ComponentTypes...>());
+        }
+
+        bool operator!=(const EachIterator &other) const
+        {
+            return position != other.position;
+        }
+
+        EachIterator &operator++()
+        {
+            position++;
+            SkipRejected();
+            return *this;
+        }
+
+        /**
+         * @brief Move to the next entity accepted by the tick filters
+         *
+         */
+        void SkipRejected()
+        {
+            if constexpr (TICK_FILTERED)
+            {
+                while (position < pEntities->size() && !Accept(pScene, (*pEntities)[position], since))
+                {
+                    position++;
+                }
+            }
+        }
+
+        template <typename Term>
+        auto Component(ComponentPool *pool, EntityIndex index) const
+        {
+            if constexpr (!Term::FETCH)
+            {
+                return static_cast<const void *>(nullptr);
+            }
+            else if constexpr (Term::MARK)
+            {
+                // Only written components unshare their page from a fork
+                pool->ticksOf(index).changed = pScene->changeTick;
+                return pool->get(index);
+            }
+            else if constexpr (Term::INCLUDE)
+            {
+                return pool->read(index);
+            }
+            else
+            {
+                return pool->contains(index) ? pool->read(index) : nullptr;
+            }
+        }
+
+        template <size_t... I>
+        Item Fetch(EntityIndex index, std::index_sequence<I...>) const
+        {
+            return std::tuple_cat(std::tuple<EntityID>(pScene->entities[index].id), QueryTerm<ComponentTypes>::Fetch(Component<QueryTerm<ComponentTypes>>(pools[I], index))...);
+        }
+
+        size_t position;
+        Scene *pScene;
+        const std::vector<EntityIndex> *pEntities;
+        ComponentPool *const *pools;
+        Tick since;
+    };
+
+    /**
+     * @brief Range over the view yielding Item tuples
+     *
+     */
+    struct EachRange
+    {
+        EachRange(Scene *pScene, SceneQuery *pQuery, Tick since) : pScene(pScene), pQuery(pQuery), since(since)
+        {
+            // Component ids are compile time constants, so every pool is a fixed slot of the scene
+            int componentIds[] = {0, Scene::GetId<typename QueryTerm<ComponentTypes>::Component>()...};
+            for (size_t i = 1; i < (sizeof...(ComponentTypes) + 1); i++)
+            {
+                pools[i - 1] = pScene->componentPools[componentIds[i]];
+            }
+        }
+
+        EachIterator begin() const
+        {
+            return EachIterator(0, pScene, &pQuery->entities, pools, since);
+        }
+
+        EachIterator end() const
+        {
+            return EachIterator(pQuery->entities.size(), pScene, &pQuery->entities, pools, since);
+        }
+
+        Scene *pScene;
+        SceneQuery *pQuery;
+        Tick since;
+        ComponentPool *pools[sizeof...(ComponentTypes) + 1]{};
+    };
+#endif
+
+    /**
+     * @brief Iterate the view with the fetched components of each entity
+     *
+     * Usage: for (auto [ent, transform, input] : SceneView<TransformComponent, InputComponent>(scene).each())
+     * or for (auto [ent, sprite, input] : SceneView<Shared<SpriteComponent>, Optional<InputComponent>, Without<ChildTag>>(scene).each())
+     *
+     * @return EachRange
+     */
+    EachRange each() const
+    {
+        return EachRange{pScene, pQuery, since};
+    }
+
+    /**
+     * @brief Call fn with the entity and fetched components of every entity, spread over the job system
+     *
+     * The matching set is cut into chunks of about grain entities that run as jobs on the scene's
+     * job system. fn may write the Mut<T> components it is given without locking since every entity
+     * is visited by one job only; structural changes must be recorded in a command buffer. Returns
+     * once every chunk is done.
+     *
+     * Chunks follow storage order so each starts on a cache line: archetype rows from the start of
+     * every archetype chunk, or with sparse sets the dense positions of the smallest pool written
+     * through Mut<T>. When that pool is more than twice the size of the view, or nothing is written,
+     * the chunks follow query order and neighbouring jobs may share a line at their edges.
+     *
+     * Usage: SceneView<TransformComponent, Mut<InputComponent>>(scene).par_each([](EntityID ent, const TransformComponent &transform, InputComponent &input) { ... });
+     *
+     * @tparam Fn Callable with the members of Item
+     * @param fn Called concurrently, once per entity
+     * @param grain Entities per job, rounded up to a multiple of 64
+     */
+    template <typename Fn>
+    void par_each(Fn &&fn, size_t grain = PAR_EACH_GRAIN) const
+    {
+        size_t chunkSize = ParallelChunkSize(grain);
+#ifdef ECS_ARCHETYPE_STORAGE
+        // Row ranges of every archetype, cut at multiples of chunkSize from the start of each chunk so
+        // every range starts on a cache line of every column. A range never spans two archetypes
+        struct RowRange
+        {
+            size_t archetype;
+            size_t begin;
+            size_t end;
+        };
+        std::vector<RowRange> ranges;
+        for (size_t archetype = 0; archetype < pQuery->archetypes.size(); archetype++)
+        {
+            const Archetype *pArchetype = pQuery->archetypes[archetype];
+            for (size_t chunkBegin = 0; chunkBegin < pArchetype->count; chunkBegin += pArchetype->chunkCapacity)
+            {
+                size_t chunkEnd = std::min(pArchetype->count, chunkBegin + pArchetype->chunkCapacity);
+                for (size_t begin = chunkBegin; begin < chunkEnd; begin += chunkSize)
+                {
+                    size_t end = std::min(chunkEnd, begin + chunkSize);
+                    // Chunks holding fewer rows than a job are merged whole
+                    if (!ranges.empty() && ranges.back().archetype == archetype && ranges.back().end == begin && ranges.back().end - ranges.back().begin < chunkSize)
+                    {
+                        ranges.back().end = end;
+                    }
+                    else
+                    {
+                        ranges.push_back({archetype, begin, end});
+                    }
+                }
+            }
+        }
+        auto runChunk = [&](size_t chunk)
+        {
+            const RowRange &range = ranges[chunk];
+            for (EachIterator it(pScene, &pQuery->archetypes, range.archetype, since, range.begin); it.archetype == range.archetype && it.row < range.end; ++it)
+            {
+                std::apply(fn, *it);
+            }
+        };
+        ParallelChunks(pScene, ranges.size(), runChunk);
+#else
+        EachRange range = each();
+        size_t count = pQuery->entities.size();
+
+        // Jobs writing a component walk the dense positions of its pool, so their slices of the pool
+        // and of its ticks start on cache lines. Worth it while most of the pool matches the view
+        ComponentPool *pPrimary = nullptr;
+        bool marked[] = {false, QueryTerm<ComponentTypes>::MARK...};
+        for (size_t i = 1; i < (sizeof...(ComponentTypes) + 1); i++)
+        {
+            ComponentPool *pool = range.pools[i - 1];
+            if (marked[i] && pool != nullptr && pool->size() <= 2 * count && (pPrimary == nullptr || pool->size() < pPrimary->size()))
+            {
+                pPrimary = pool;
+            }
+        }
+        if (pPrimary != nullptr)
+        {
+            size_t poolSize = pPrimary->size();
+            auto runChunk = [&](size_t chunk)
+            {
+                // Positioned at the end so construction skips nothing, it only fetches
+                EachIterator fetch(poolSize, pScene, &pPrimary->dense, range.pools, since);
+                for (size_t position = chunk * chunkSize, end = std::min(poolSize, (chunk + 1) * chunkSize); position < end; position++)
+                {
+                    EntityIndex index = pPrimary->dense[position];
+                    if (pQuery->Matches(pScene->entities[index].mask) && Accept(pScene, index, since))
+                    {
+                        std::apply(fn, fetch.Fetch(index, std::index_sequence_for<ComponentTypes...>()));
+                    }
+                }
+            };
+            ParallelChunks(pScene, (poolSize + chunkSize - 1) / chunkSize, runChunk);
+            return;
+        }
+
+        auto runChunk = [&](size_t chunk)
+        {
+            size_t end = std::min(count, (chunk + 1) * chunkSize);
+            for (EachIterator it(chunk * chunkSize, pScene, &pQuery->entities, range.pools, since); it.position < end; ++it)
+            {
+                std::apply(fn, *it);
+            }
+        };
+        ParallelChunks(pScene, (count + chunkSize - 1) / chunkSize, runChunk);
+#endif
     }
 
     Scene *pScene{nullptr};
+    SceneQuery *pQuery{nullptr};
+    Tick since{0};
     ComponentMask componentMask;
+    ComponentMask excludeMask;
     bool all{false};
 };
+
+/**
+ * @brief Iterator over an owning group: the entities having every one of Components
+ *
+ * With sparse sets, building the group the first time registers an OwningGroup with the scene,
+ * which from then on keeps the members packed at the front of every owned pool in the same order.
+ * each() walks the pools in lockstep page by page, without mask tests or sparse lookups. With
+ * archetype storage the components of an archetype are already stored side by side, so the group
+ * iterates like SceneView<Components...>. Components are fetched by const reference, reading pages
+ * shared with a fork in place; write them through Scene::GetMut.
+ *
+ * Usage: for (auto [ent, transform, collider] : Group<TransformComponent, Box2DColliderComponent>(scene).each())
+ *
+ * @tparam Components Owned components, plain components only
+ */
+template <typename... Components>
+struct Group
+{
+    typedef std::tuple<EntityID, const Components &...> Item;
+
+#ifdef ECS_ARCHETYPE_STORAGE
+    /**
+     * @brief Construct a new Group object
+     *
+     * @param scene Scene
+     */
+    Group(Scene &scene) : view(scene) {}
+
+    typename SceneView<Components...>::EachRange each() const
+    {
+        return view.each();
+    }
+
+    template <typename Fn>
+    void par_each(Fn &&fn, size_t grain = PAR_EACH_GRAIN) const
+    {
+        view.par_each(std::forward<Fn>(fn), grain);
+    }
+
+    SceneView<Components...> view;
+#else
+    /**
+     * @brief Construct a new Group object, registering the owning group on first use
+     *
+     * @param scene Scene
+     */
+    Group(Scene &scene) : pScene(&scene)
+    {
+        int componentIds[] = {Scene::GetId<Components>()...};
+        ComponentMask owned;
+        for (size_t i = 0; i < sizeof...(Components); i++)
+        {
+            owned.set(componentIds[i]);
+            pools[i] = scene.componentPools[componentIds[i]];
+        }
+        pGroup = scene.GetGroup(owned);
+    }
+
+    /**
+     * @brief Iterator yielding the entity and its owned components
+     *
+     * Page pointers are resolved when crossing a page boundary, each step only adds the component
+     * size to every column.
+     */
+    struct EachIterator
+    {
+        Item operator*() const
+        {
+            return Fetch(std::index_sequence_for<Components...>());
+        }
+
+        bool operator!=(const EachIterator &other) const
+        {
+            return position != other.position;
+        }
+
+        EachIterator &operator++()
+        {
+            position++;
+            if (position % COMPONENT_PAGE_SIZE == 0 && position < size)
+            {
+                ResolvePage();
+            }
+            return *this;
+        }
+
+        void ResolvePage()
+        {
+            size_t page = position / COMPONENT_PAGE_SIZE;
+            for (size_t i = 0; i < sizeof...(Components); i++)
+            {
+                columns[i] = pools[i]->readPage(page);
+            }
+        }
+
+        template <size_t... I>
+        Item Fetch(std::index_sequence<I...>) const
+        {
+            size_t slot = position % COMPONENT_PAGE_SIZE;
+            return Item(pScene->entities[pools[0]->dense[position]].id, reinterpret_cast<const Components *>(columns[I])[slot]...);
+        }
+
+        size_t position;
+        size_t size;
+        Scene *pScene;
+        ComponentPool *const *pools;
+        const char *columns[sizeof...(Components)]{};
+    };
+
+    /**
+     * @brief Range over the members of the group yielding Item tuples
+     *
+     */
+    struct EachRange
+    {
+        EachIterator begin() const
+        {
+            EachIterator it{0, size, pScene, pools};
+            if (size > 0)
+            {
+                it.ResolvePage();
+            }
+            return it;
+        }
+
+        EachIterator end() const
+        {
+            return EachIterator{size, size, pScene, pools};
+        }
+
+        size_t size;
+        Scene *pScene;
+        ComponentPool *pools[sizeof...(Components)];
+    };
+
+    /**
+     * @brief Iterate the members of the group with their owned components
+     *
+     * @return EachRange
+     */
+    EachRange each() const
+    {
+        // The range outlives the group in a range-based for, so it keeps its own copy of the pools
+        EachRange range{size(), pScene, {}};
+        std::copy(std::begin(pools), std::end(pools), range.pools);
+        return range;
+    }
+
+    /**
+     * @brief Call fn with every member and its owned components, spread over the job system
+     *
+     * Members are packed at the same positions of every owned pool, so each job walks the same
+     * slice of every column and its component and tick slices start on cache lines.
+     *
+     * @tparam Fn Callable with the members of Item
+     * @param fn Called concurrently, once per member
+     * @param grain Members per job, rounded up to a multiple of 64
+     */
+    template <typename Fn>
+    void par_each(Fn &&fn, size_t grain = PAR_EACH_GRAIN) const
+    {
+        size_t chunkSize = ParallelChunkSize(grain);
+        size_t count = size();
+        auto runChunk = [&](size_t chunk)
+        {
+            EachIterator it{chunk * chunkSize, count, pScene, pools};
+            it.ResolvePage();
+            for (size_t end = std::min(count, (chunk + 1) * chunkSize); it.position < end; ++it)
+            {
+                std::apply(fn, *it);
+            }
+        };
+        ParallelChunks(pScene, (count + chunkSize - 1) / chunkSize, runChunk);
+    }
+
+    /**
+     * @brief Number of entities in the group
+     *
+     * @return size_t 0 if the group could not be registered
+     */
+    size_t size() const
+    {
+        return pGroup ? pGroup->size : 0;
+    }
+
+    Scene *pScene;
+    OwningGroup *pGroup{nullptr};
+    ComponentPool *pools[sizeof...(Components)]{};
+#endif
+};
+
+/**
+ * @brief Entities of a view grouped by the value of a shared component
+ *
+ * Refresh walks SceneView<Shared<T>, Terms...> once and buckets each entity by the slot of its
+ * shared value, so a system can handle every entity using one value together (the renderer draws
+ * all sprites of a texture in a row). Groups are ordered by the first entity using their value and
+ * the buffers are kept between refreshes.
+ *
+ * Usage: for (auto &group : groups.Refresh()) for (auto [ent, sprite, transform] : group.items)
+ *
+ * @tparam T Shared component
+ * @tparam Terms Additional components and filters of the view
+ */
+template <typename T, typename... Terms>
+struct SharedGroups
+{
+    typedef SceneView<Shared<T>, Terms...> View;
+
+    /**
+     * @brief Entities using one shared value
+     *
+     */
+    struct Group
+    {
+        const T *value{nullptr};
+        std::vector<typename View::Item> items;
+    };
+
+    /**
+     * @brief Construct a new Shared Groups object
+     *
+     * @param scene Scene
+     */
+    SharedGroups(Scene &scene) : pScene(&scene) {}
+
+    /**
+     * @brief Rebuild the groups from the current state of the scene
+     *
+     * @param since Tick passed to the view for Changed<T> and Added<T> terms
+     * @return SharedGroups& Range over the non empty groups
+     */
+    SharedGroups &Refresh(Tick since = 0)
+    {
+        for (size_t i = 0; i < used; i++)
+        {
+            groups[i].items.clear();
+        }
+        used = 0;
+        groupOfSlot.assign(pScene->GetSharedStore<T>().SlotCount(), size_t(-1));
+
+        for (auto item : View(*pScene, since).each())
+        {
+            const Shared<T> &handle = std::get<1>(item);
+            size_t &groupIndex = groupOfSlot[handle.Slot()];
+            if (groupIndex == size_t(-1))
+            {
+                groupIndex = used++;
+                if (groups.size() < used)
+                {
+                    groups.emplace_back();
+                }
+                groups[groupIndex].value = handle.get();
+            }
+            groups[groupIndex].items.push_back(item);
+        }
+
+        return *this;
+    }
+
+    typename std::vector<Group>::iterator begin() { return groups.begin(); }
+    typename std::vector<Group>::iterator end() { return groups.begin() + used; }
+    size_t size() const { return used; }
+
+    Scene *pScene;
+    std::vector<Group> groups;       // Groups of the last refresh first, then spare buffers
+    size_t used{0};                  // Non empty groups
+    std::vector<size_t> groupOfSlot; // Group of each shared value slot, -1 if unused
+};
@@ -0,0 +1,242 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+template <typename T>
+struct SharedStore;
+
+/**
+ * @brief A component value stored once and referenced by every entity using it
+ *
+ * @tparam T Component
+ */
+template <typename T>
+struct SharedValue
+{
+    T value;
+    size_t hash{0};
+    uint32_t refs{0};
+    uint32_t slot{0};                  // Dense id of the value in its store, used to group entities
+    SharedStore<T> *store{nullptr};    // Store the value is interned in, null once the store is gone
+};
+
+/**
+ * @brief Reference counted handle to a shared component value
+ *
+ * Entities hold a Shared<T> as a regular component, so identical values (a sprite's path, size and
+ * texture for instance) are stored once however many entities use them. The value is immutable
+ * through the handle: to change it, assign a handle to the new value from Scene::Share. Handles
+ * are not thread safe and must be copied and released on the thread owning the scene.
+ *
+ * @tparam T Shared component, needs operator== and a std::hash specialization
+ */
+template <typename T>
+struct Shared
+{
+    Shared() = default;
+
+    explicit Shared(SharedValue<T> *pValue) : node(pValue)
+    {
+        Acquire();
+    }
+
+    Shared(const Shared &other) : node(other.node)
+    {
+        Acquire();
+    }
+
+    Shared(Shared &&other) noexcept : node(other.node)
+    {
+        other.node = nullptr;
+    }
+
+    Shared &operator=(const Shared &other)
+    {
+        Shared copy(other);
+        std::swap(node, copy.node);
+        return *this;
+    }
+
+    Shared &operator=(Shared &&other) noexcept
+    {
+        std::swap(node, other.node);
+        return *this;
+    }
+
+    ~Shared()
+    {
+        Release();
+    }
+
+    const T &operator*() const { return node->value; }
+    const T *operator->() const { return &node->value; }
+    const T *get() const { return node ? &node->value : nullptr; }
+    explicit operator bool() const { return node != nullptr; }
+
+    bool operator==(const Shared &other) const { return node == other.node; }
+    bool operator!=(const Shared &other) const { return node != other.node; }
+
+    /**
+     * @brief Dense id of the value in its store, equal for every handle to the same value
+     *
+     * @return uint32_t
+     */
+    uint32_t Slot() const { return node->slot; }
+
+    /**
+     * @brief Number of handles to the value
+     *
+     * @return uint32_t
+     */
+    uint32_t UseCount() const { return node ? node->refs : 0; }
+
+private:
+    void Acquire()
+    {
+        if (node)
+        {
+            node->refs++;
+        }
+    }
+
+    void Release();
+
+    SharedValue<T> *node{nullptr};
+};
+
+/**
+ * @brief Type erased base of the shared value stores owned by a Scene
+ *
+ */
+struct SharedStoreBase
+{
+    virtual ~SharedStoreBase() = default;
+};
+
+/**
+ * @brief Hash set of the shared values of one component type
+ *
+ * Values are looked up by hash and compared with operator==, so interning an equal value returns
+ * a handle to the existing one. A value is freed when its last handle goes away and its slot is
+ * reused by the next new value, keeping slots dense for grouping.
+ *
+ * @tparam T Shared component
+ */
+template <typename T>
+struct SharedStore : SharedStoreBase
+{
+    /**
+     * @brief Destroy the Shared Store object, detaching values still referenced by handles
+     *
+     * Detached values are freed by their last handle.
+     */
+    ~SharedStore() override
+    {
+        for (SharedValue<T> *pValue : slots)
+        {
+            if (pValue)
+            {
+                pValue->store = nullptr;
+            }
+        }
+    }
+
+    /**
+     * @brief Get a handle to a value equal to value, storing it if it is not shared yet
+     *
+     * @param value Component value
+     * @return Shared<T>
+     */
+    Shared<T> Intern(const T &value)
+    {
+        size_t hash = std::hash<T>()(value);
+        auto range = lookup.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (it->second->value == value)
+            {
+                return Shared<T>(it->second);
+            }
+        }
+
+        SharedValue<T> *pValue = new SharedValue<T>{value, hash, 0, 0, this};
+        if (freeSlots.empty())
+        {
+            pValue->slot = uint32_t(slots.size());
+            slots.push_back(pValue);
+        }
+        else
+        {
+            pValue->slot = freeSlots.back();
+            freeSlots.pop_back();
+            slots[pValue->slot] = pValue;
+        }
+        lookup.emplace(hash, pValue);
+        return Shared<T>(pValue);
+    }
+
+    /**
+     * @brief Forget a value whose last handle was released
+     *
+     * @param pValue Value to free
+     */
+    void Erase(SharedValue<T> *pValue)
+    {
+        auto range = lookup.equal_range(pValue->hash);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (it->second == pValue)
+            {
+                lookup.erase(it);
+                break;
+            }
+        }
+        slots[pValue->slot] = nullptr;
+        freeSlots.push_back(pValue->slot);
+        delete pValue;
+    }
+
+    /**
+     * @brief Number of distinct values currently shared
+     *
+     * @return size_t
+     */
+    size_t Size() const
+    {
+        return lookup.size();
+    }
+
+    /**
+     * @brief Upper bound of the slots of the stored values
+     *
+     * @return size_t
+     */
+    size_t SlotCount() const
+    {
+        return slots.size();
+    }
+
+    std::unordered_multimap<size_t, SharedValue<T> *> lookup; // Values by hash
+    std::vector<SharedValue<T> *> slots;                       // Values by slot, null for free slots
+    std::vector<uint32_t> freeSlots;
+};
+
+template <typename T>
+void Shared<T>::Release()
+{
+    if (node && --node->refs == 0)
+    {
+        if (node->store)
+        {
+            node->store->Erase(node);
+        }
+        else
+        {
+            delete node;
+        }
+    }
+    node = nullptr;
+}
@@ -0,0 +1,397 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include "Constants.hpp"
+
+/**
+ * @brief Interleave the bits of the cell coordinates of a position into a Z-order curve index
+ *
+ * Positions close on screen get close codes, so sorting by code keeps neighbours together.
+ *
+ * @param x Position x
+ * @param y Position y
+ * @param cellSize Size of the cells the position is quantized to
+ * @return uint32_t Morton code, 16 bits per axis
+ */
+inline uint32_t MortonCode(float x, float y, float cellSize)
+{
+    auto spread = [](float coordinate, float size)
+    {
+        // Bias so negative positions sort before positive ones, clamped to 16 bits
+        float cell = std::floor(coordinate / size) + 32768.0f;
+        uint32_t bits = uint32_t(std::min(std::max(cell, 0.0f), 65535.0f));
+        bits = (bits | (bits << 8)) & 0x00FF00FFu;
+        bits = (bits | (bits << 4)) & 0x0F0F0F0Fu;
+        bits = (bits | (bits << 2)) & 0x33333333u;
+        bits = (bits | (bits << 1)) & 0x55555555u;
+        return bits;
+    };
+    return spread(x, cellSize) | (spread(y, cellSize) << 1);
+}
+
+/**
+ * @brief Uniform grid spatial hash over the bounds of entities
+ *
+ * Every entry is an axis aligned box, anchored at the entity's TransformComponent and sized by its
+ * BoundsComponent (a point when it has none). An entry is listed in each grid cell it overlaps, so
+ * a query only visits the cells covering its area. Cells are hashed, so the world is unbounded and
+ * empty space costs nothing. Entries are keyed by entity index; Scene::UpdateSpatialIndex moves
+ * the entries of the entities whose transform or bounds changed.
+ */
+struct SpatialHash
+{
+    /**
+     * @brief Bounds of an indexed entity and the cells it is listed in
+     *
+     */
+    struct Entry
+    {
+        EntityID id{EntityID(-1)};
+        float minX{0.0f}, minY{0.0f}, maxX{0.0f}, maxY{0.0f};
+        int cellMinX{0}, cellMinY{0}, cellMaxX{-1}, cellMaxY{-1}; // Empty range when not indexed
+        uint32_t stamp{0};                                        // Last query that visited the entry
+        uint32_t trackedPosition{0};                              // Position in the tracked list
+    };
+
+    /**
+     * @brief Construct a new Spatial Hash object
+     *
+     * @param size Width and height of a cell in pixels
+     */
+    SpatialHash(float size = 64.0f) : cellSize(size) {}
+
+    /**
+     * @brief Check if the entity at index is indexed
+     *
+     * @param index Entity index
+     * @return true if it has an entry
+     */
+    inline bool Contains(EntityIndex index) const
+    {
+        return index < entries.size() && entries[index].id != EntityID(-1);
+    }
+
+    /**
+     * @brief Insert or move the entry of an entity
+     *
+     * @param index Entity index
+     * @param id Entity ID
+     * @param minX Left edge
+     * @param minY Top edge
+     * @param maxX Right edge
+     * @param maxY Bottom edge
+     */
+    void Update(EntityIndex index, EntityID id, float minX, float minY, float maxX, float maxY)
+    {
+        if (entries.size() <= index)
+        {
+            entries.resize(index + 1);
+        }
+        Entry &entry = entries[index];
+        if (entry.id == EntityID(-1))
+        {
+            entry.trackedPosition = uint32_t(tracked.size());
+            tracked.push_back(index);
+        }
+        entry.id = id;
+        entry.minX = minX;
+        entry.minY = minY;
+        entry.maxX = maxX;
+        entry.maxY = maxY;
+
+        int cellMinX = CellOf(minX), cellMinY = CellOf(minY), cellMaxX = CellOf(maxX), cellMaxY = CellOf(maxY);
+        if (cellMinX == entry.cellMinX && cellMinY == entry.cellMinY && cellMaxX == entry.cellMaxX && cellMaxY == entry.cellMaxY)
+        {
+            return;
+        }
+
+        Unlink(index);
+        entry.cellMinX = cellMinX;
+        entry.cellMinY = cellMinY;
+        entry.cellMaxX = cellMaxX;
+        entry.cellMaxY = cellMaxY;
+        for (int cy = cellMinY; cy <= cellMaxY; cy++)
+        {
+            for (int cx = cellMinX; cx <= cellMaxX; cx++)
+            {
+                cells[Key(cx, cy)].push_back(index);
+            }
+        }
+        occupiedMinX = std::min(occupiedMinX, cellMinX);
+        occupiedMinY = std::min(occupiedMinY, cellMinY);
+        occupiedMaxX = std::max(occupiedMaxX, cellMaxX);
+        occupiedMaxY = std::max(occupiedMaxY, cellMaxY);
+    }
+
+    /**
+     * @brief Remove the entry of an entity
+     *
+     * @param index Entity index
+     */
+    void Erase(EntityIndex index)
+    {
+        if (!Contains(index))
+        {
+            return;
+        }
+        Unlink(index);
+        uint32_t position = entries[index].trackedPosition;
+        tracked[position] = tracked.back();
+        entries[tracked[position]].trackedPosition = position;
+        tracked.pop_back();
+        entries[index] = Entry();
+    }
+
+    /**
+     * @brief Find the entities whose bounds overlap a box
+     *
+     * @param minX Left edge
+     * @param minY Top edge
+     * @param maxX Right edge
+     * @param maxY Bottom edge
+     * @param result Output, cleared first
+     */
+    void QueryAABB(float minX, float minY, float maxX, float maxY, std::vector<EntityID> &result)
+    {
+        result.clear();
+        ForEachCandidate(minX, minY, maxX, maxY, [&](const Entry &entry)
+                         {
+            if (entry.minX <= maxX && entry.maxX >= minX && entry.minY <= maxY && entry.maxY >= minY)
+            {
+                result.push_back(entry.id);
+            } });
+    }
+
+    /**
+     * @brief Find the entities whose bounds are within a distance of a point
+     *
+     * @param x Center x
+     * @param y Center y
+     * @param radius Distance
+     * @param result Output, cleared first
+     */
+    void QueryRadius(float x, float y, float radius, std::vector<EntityID> &result)
+    {
+        result.clear();
+        float radiusSquared = radius * radius;
+        ForEachCandidate(x - radius, y - radius, x + radius, y + radius, [&](const Entry &entry)
+                         {
+            if (DistanceSquared(entry, x, y) <= radiusSquared)
+            {
+                result.push_back(entry.id);
+            } });
+    }
+
+    /**
+     * @brief Find the k entities closest to a point, nearest first
+     *
+     * Searches rings of cells around the point and stops once no unvisited cell can hold a closer
+     * entity than the k-th found so far.
+     *
+     * @param x Point x
+     * @param y Point y
+     * @param k Number of entities
+     * @param result Output, cleared first
+     */
+    void QueryNearest(float x, float y, size_t k, std::vector<EntityID> &result)
+    {
+        result.clear();
+        if (k == 0 || tracked.empty())
+        {
+            return;
+        }
+
+        nearest.clear();
+        stamp++;
+        int centerX = CellOf(x), centerY = CellOf(y);
+        auto byDistance = [](const std::pair<float, EntityID> &a, const std::pair<float, EntityID> &b)
+        { return a.first < b.first; };
+        // Rings closer than the occupied area hold no entity, start at the first one reaching it
+        int firstRing = std::max({0, occupiedMinX - centerX, centerX - occupiedMaxX, occupiedMinY - centerY, centerY - occupiedMaxY});
+        for (int ring = firstRing;; ring++)
+        {
+            for (int cy = centerY - ring; cy <= centerY + ring; cy++)
+            {
+                // Only the border of the ring, the inside was visited by the previous rings
+                int step = (cy == centerY - ring || cy == centerY + ring) ? 1 : std::max(1, 2 * ring);
+                for (int cx = centerX - ring; cx <= centerX + ring; cx += step)
+                {
+                    auto cell = cells.find(Key(cx, cy));
+                    if (cell == cells.end())
+                    {
+                        continue;
+                    }
+                    for (EntityIndex index : cell->second)
+                    {
+                        Entry &entry = entries[index];
+                        if (entry.stamp == stamp)
+                        {
+                            continue;
+                        }
+                        entry.stamp = stamp;
+                        float distance = DistanceSquared(entry, x, y);
+                        if (nearest.size() < k)
+                        {
+                            nearest.emplace_back(distance, entry.id);
+                            std::push_heap(nearest.begin(), nearest.end(), byDistance);
+                        }
+                        else if (distance < nearest.front().first)
+                        {
+                            std::pop_heap(nearest.begin(), nearest.end(), byDistance);
+                            nearest.back() = {distance, entry.id};
+                            std::push_heap(nearest.begin(), nearest.end(), byDistance);
+                        }
+                    }
+                }
+            }
+
+            // Anything in a further ring is at least ring cells away from the point
+            float reach = ring * cellSize;
+            bool full = nearest.size() == k && nearest.front().first <= reach * reach;
+            bool exhausted = centerX - ring <= occupiedMinX && centerY - ring <= occupiedMinY &&
+                             centerX + ring >= occupiedMaxX && centerY + ring >= occupiedMaxY;
+            if (full || exhausted)
+            {
+                break;
+            }
+        }
+
+        std::sort_heap(nearest.begin(), nearest.end(), byDistance);
+        for (const std::pair<float, EntityID> &candidate : nearest)
+        {
+            result.push_back(candidate.second);
+        }
+    }
+
+    /**
+     * @brief Find the entity under a point
+     *
+     * @param x Point x
+     * @param y Point y
+     * @return EntityID The smallest entity whose bounds contain the point, -1 if there is none
+     */
+    EntityID Pick(float x, float y)
+    {
+        EntityID picked = EntityID(-1);
+        float pickedArea = std::numeric_limits<float>::max();
+        ForEachCandidate(x, y, x, y, [&](const Entry &entry)
+                         {
+            float area = (entry.maxX - entry.minX) * (entry.maxY - entry.minY);
+            if (entry.minX <= x && x <= entry.maxX && entry.minY <= y && y <= entry.maxY && area < pickedArea)
+            {
+                picked = entry.id;
+                pickedArea = area;
+            } });
+        return picked;
+    }
+
+    /**
+     * @brief Remove every entry, keeping the allocated storage
+     *
+     */
+    void Clear()
+    {
+        entries.clear();
+        tracked.clear();
+        cells.clear();
+        occupiedMinX = occupiedMinY = std::numeric_limits<int>::max();
+        occupiedMaxX = occupiedMaxY = std::numeric_limits<int>::min();
+    }
+
+    float cellSize;
+    std::vector<Entry> entries;       // Indexed by entity index
+    std::vector<EntityIndex> tracked; // Entity indices with an entry
+    Tick lastUpdate{0};               // Tick closing the last Scene::UpdateSpatialIndex
+    std::unordered_map<uint64_t, std::vector<EntityIndex>> cells;
+    int occupiedMinX{std::numeric_limits<int>::max()}, occupiedMinY{std::numeric_limits<int>::max()};
+    int occupiedMaxX{std::numeric_limits<int>::min()}, occupiedMaxY{std::numeric_limits<int>::min()};
+    uint32_t stamp{0}; // Incremented by every query to visit entries listed in several cells once
+    std::vector<std::pair<float, EntityID>> nearest; // Max heap of QueryNearest
+
+private:
+    inline int CellOf(float coordinate) const
+    {
+        return int(std::floor(coordinate / cellSize));
+    }
+
+    static inline uint64_t Key(int cx, int cy)
+    {
+        return (uint64_t(uint32_t(cx)) << 32) | uint32_t(cy);
+    }
+
+    static inline float DistanceSquared(const Entry &entry, float x, float y)
+    {
+        float dx = std::max(std::max(entry.minX - x, 0.0f), x - entry.maxX);
+        float dy = std::max(std::max(entry.minY - y, 0.0f), y - entry.maxY);
+        return dx * dx + dy * dy;
+    }
+
+    /**
+     * @brief Remove an entry from the cells it is listed in
+     *
+     * @param index Entity index
+     */
+    void Unlink(EntityIndex index)
+    {
+        Entry &entry = entries[index];
+        for (int cy = entry.cellMinY; cy <= entry.cellMaxY; cy++)
+        {
+            for (int cx = entry.cellMinX; cx <= entry.cellMaxX; cx++)
+            {
+                auto cell = cells.find(Key(cx, cy));
+                std::vector<EntityIndex> &members = cell->second;
+                *std::find(members.begin(), members.end(), index) = members.back();
+                members.pop_back();
+                if (members.empty())
+                {
+                    cells.erase(cell);
+                }
+            }
+        }
+        entry.cellMaxX = entry.cellMinX - 1;
+        entry.cellMaxY = entry.cellMinY - 1;
+    }
+
+    /**
+     * @brief Call fn once for each entry listed in a cell overlapping a box
+     *
+     * @tparam Fn void(const Entry &)
+     * @param minX Left edge
+     * @param minY Top edge
+     * @param maxX Right edge
+     * @param maxY Bottom edge
+     * @param fn Callback
+     */
+    template <typename Fn>
+    void ForEachCandidate(float minX, float minY, float maxX, float maxY, Fn &&fn)
+    {
+        stamp++;
+        int cellMinX = std::max(CellOf(minX), occupiedMinX), cellMinY = std::max(CellOf(minY), occupiedMinY);
+        int cellMaxX = std::min(CellOf(maxX), occupiedMaxX), cellMaxY = std::min(CellOf(maxY), occupiedMaxY);
+        for (int cy = cellMinY; cy <= cellMaxY; cy++)
+        {
+            for (int cx = cellMinX; cx <= cellMaxX; cx++)
+            {
+                auto cell = cells.find(Key(cx, cy));
+                if (cell == cells.end())
+                {
+                    continue;
+                }
+                for (EntityIndex index : cell->second)
+                {
+                    Entry &entry = entries[index];
+                    if (entry.stamp != stamp)
+                    {
+                        entry.stamp = stamp;
+                        fn(entry);
+                    }
+                }
+            }
+        }
+    }
+};
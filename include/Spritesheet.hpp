@@ -8,7 +8,7 @@
 #include <iostream>
 #include "Board.hpp"
 #include "ResourceManager.hpp"
-#include "SDLLayer.hpp"
+#include "RenderPacket.hpp"
 
 /**
  * @brief Sprite Sheet class
@@ -67,11 +67,11 @@ public:
     void AddTileId(int id, int xpos, int ypos);
 
     /**
-     * @brief Render the sprite sheet
+     * @brief Copy a draw command for each tile of the sprite sheet into a render packet
      *
-     * @param sdlLayer
+     * @param packet
      */
-    void Render(SDLLayer *const sdlLayer) const;
+    void Extract(RenderPacket &packet) const;
 
     // Getters to Access SpriteSheet info
     SDL_Texture *GetTileSetTexture() const
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "JobSystem.hpp"
+#include "Scene.hpp"
+
+/**
+ * @brief A system registered with a SystemScheduler and the components it touches
+ *
+ */
+struct SystemDesc
+{
+    std::string name;
+    std::function<void()> run;
+    ComponentMask reads;     // Components the system only reads
+    ComponentMask writes;    // Components the system writes
+    bool exclusive{false};   // Touches state no mask describes (scripts, structural changes), runs alone
+    bool mainThread{false};  // Must run on the thread calling Run, for instance to call into Python
+};
+
+/**
+ * @brief Runs systems concurrently on a JobSystem, ordered by the components they share
+ *
+ * Two systems conflict when one writes a component the other reads or writes, or when either is
+ * exclusive. Conflicting systems run in the order they were added, the others run at the same
+ * time. The resulting graph is rebuilt only when systems or constraints are added, each Run walks
+ * it by releasing the systems whose predecessors have finished.
+ */
+class SystemScheduler
+{
+public:
+    typedef size_t SystemHandle;
+
+    /**
+     * @brief Construct a new System Scheduler object
+     *
+     * @param jobs Pool running the systems
+     */
+    explicit SystemScheduler(JobSystem *jobs) : m_jobs(jobs) {}
+
+    /**
+     * @brief Register a system, it runs after the conflicting systems added before it
+     *
+     * @param system System description
+     * @return SystemHandle
+     */
+    SystemHandle Add(SystemDesc system);
+
+    /**
+     * @brief Make a system wait for another even if they touch different components
+     *
+     * @param before System running first
+     * @param after System running once before has finished
+     */
+    void After(SystemHandle before, SystemHandle after);
+
+    /**
+     * @brief Run every system once and wait for all of them
+     *
+     * @param serial Run the systems one after the other in a valid order on the calling thread, for debugging
+     */
+    void Run(bool serial = false);
+
+    /**
+     * @brief Start running every system once and return, so the calling thread can do other work
+     *
+     * The systems needing the calling thread only run once Finish is called.
+     *
+     * @param serial Run the systems one after the other on the calling thread before returning
+     */
+    void Start(bool serial = false);
+
+    /**
+     * @brief Run the main thread systems of the run begun by Start and wait for all systems
+     *
+     */
+    void Finish();
+
+    /**
+     * @brief Build the mask of a list of components
+     *
+     * @tparam Components Components
+     * @return ComponentMask
+     */
+    template <typename... Components>
+    static ComponentMask Mask()
+    {
+        ComponentMask mask;
+        (mask.set(Scene::GetId<Components>()), ...);
+        return mask;
+    }
+
+private:
+    /**
+     * @brief Derive the dependency edges and a topological order of the systems
+     *
+     */
+    void Build();
+
+    /**
+     * @brief Hand a system whose predecessors have finished to the pool or the calling thread
+     *
+     * @param system System index
+     * @param counter Counter of the current run
+     */
+    void Release(size_t system, JobCounter &counter);
+
+    /**
+     * @brief Run a system and release the dependents it was the last predecessor of
+     *
+     * @param system System index
+     * @param counter Counter of the current run
+     */
+    void Execute(size_t system, JobCounter &counter);
+
+    JobSystem *const m_jobs;
+    std::vector<SystemDesc> m_systems;
+    std::vector<std::pair<SystemHandle, SystemHandle>> m_constraints; // Explicit before/after pairs
+    std::vector<std::vector<size_t>> m_dependents;                    // Systems waiting on each system
+    std::vector<size_t> m_dependencyCounts;                           // Predecessors of each system
+    std::vector<size_t> m_order;                                      // Topological order
+    std::unique_ptr<std::atomic<size_t>[]> m_remaining;               // Unfinished predecessors during a run
+    std::vector<size_t> m_mainReady;                                  // Main thread systems ready to run
+    JobCounter m_counter;                                             // Unfinished systems of the current run
+    std::mutex m_mainMutex;
+    bool m_dirty = true;
+};
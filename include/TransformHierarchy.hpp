@@ -0,0 +1,180 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <numeric>
+#include "Constants.hpp"
+
+/**
+ * @brief Parent links of the entities attached to another entity, kept sorted by depth
+ *
+ * Every entity with a parent is a node. Nodes are stored as parallel arrays ordered breadth first
+ * (all children of roots, then their children, ...), so a single forward pass visits a parent
+ * before its children and reads the arrays sequentially. Attaching and detaching only mark the
+ * order stale; it is rebuilt by Sort before the next pass.
+ */
+struct TransformHierarchy
+{
+    static constexpr uint32_t NO_NODE = uint32_t(-1);
+
+    /**
+     * @brief Get the node of an entity
+     *
+     * @param index Entity index
+     * @return uint32_t NO_NODE if the entity has no parent
+     */
+    inline uint32_t NodeOf(EntityIndex index) const
+    {
+        return index < nodeOf.size() ? nodeOf[index] : NO_NODE;
+    }
+
+    /**
+     * @brief Set the parent of an entity, adding a node for it if needed
+     *
+     * @param index Entity index of the child
+     * @param child Child entity
+     * @param parent Parent entity
+     */
+    void Attach(EntityIndex index, EntityID child, EntityID parent)
+    {
+        uint32_t node = NodeOf(index);
+        if (node == NO_NODE)
+        {
+            if (nodeOf.size() <= index)
+            {
+                nodeOf.resize(index + 1, NO_NODE);
+            }
+            node = uint32_t(entities.size());
+            nodeOf[index] = node;
+            entities.push_back(child);
+            parents.push_back(parent);
+            parentNodes.push_back(NO_NODE);
+            depths.push_back(1);
+        }
+        parents[node] = parent;
+        entities[node] = child;
+        sorted = false;
+    }
+
+    /**
+     * @brief Remove the node of an entity, its children keep it as their parent
+     *
+     * @param index Entity index of the child
+     */
+    void Detach(EntityIndex index)
+    {
+        uint32_t node = NodeOf(index);
+        if (node == NO_NODE)
+        {
+            return;
+        }
+
+        // Move the last node into the hole, all arrays together so they stay valid until the next Sort
+        uint32_t last = uint32_t(entities.size() - 1);
+        if (node != last)
+        {
+            entities[node] = entities[last];
+            parents[node] = parents[last];
+            parentNodes[node] = parentNodes[last];
+            depths[node] = depths[last];
+            nodeOf[entities[node] >> 32] = node;
+        }
+        for (uint32_t &parentNode : parentNodes)
+        {
+            if (parentNode == node)
+            {
+                parentNode = NO_NODE;
+            }
+            else if (parentNode == last)
+            {
+                parentNode = node;
+            }
+        }
+        entities.pop_back();
+        parents.pop_back();
+        parentNodes.pop_back();
+        depths.pop_back();
+        nodeOf[index] = NO_NODE;
+        sorted = false;
+    }
+
+    /**
+     * @brief Restore the breadth first order and the parent node links after nodes changed
+     *
+     */
+    void Sort()
+    {
+        if (sorted)
+        {
+            return;
+        }
+
+        // Depth of a node is one more than the depth of its parent node, roots are depth 0
+        std::fill(depths.begin(), depths.end(), 0);
+        std::vector<uint32_t> chain;
+        for (uint32_t node = 0; node < entities.size(); node++)
+        {
+            uint32_t current = node;
+            while (current != NO_NODE && depths[current] == 0)
+            {
+                chain.push_back(current);
+                current = NodeOf(EntityIndex(parents[current] >> 32));
+            }
+            uint32_t depth = current == NO_NODE ? 0 : depths[current];
+            while (!chain.empty())
+            {
+                depths[chain.back()] = ++depth;
+                chain.pop_back();
+            }
+        }
+
+        std::vector<uint32_t> order(entities.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b)
+                         { return depths[a] < depths[b]; });
+
+        std::vector<EntityID> sortedEntities(entities.size());
+        std::vector<EntityID> sortedParents(entities.size());
+        std::vector<uint32_t> sortedDepths(entities.size());
+        for (uint32_t node = 0; node < order.size(); node++)
+        {
+            sortedEntities[node] = entities[order[node]];
+            sortedParents[node] = parents[order[node]];
+            sortedDepths[node] = depths[order[node]];
+            nodeOf[sortedEntities[node] >> 32] = node;
+        }
+        entities.swap(sortedEntities);
+        parents.swap(sortedParents);
+        depths.swap(sortedDepths);
+        for (uint32_t node = 0; node < entities.size(); node++)
+        {
+            parentNodes[node] = NodeOf(EntityIndex(parents[node] >> 32));
+        }
+        sorted = true;
+    }
+
+    /**
+     * @brief Remove every node, keeping the allocated storage
+     *
+     */
+    void Clear()
+    {
+        entities.clear();
+        parents.clear();
+        parentNodes.clear();
+        depths.clear();
+        nodeOf.clear();
+        dirty.clear();
+        sorted = true;
+    }
+
+    std::vector<EntityID> entities;    // Child entity of each node
+    std::vector<EntityID> parents;     // Parent entity of each node
+    std::vector<uint32_t> parentNodes; // Node of the parent, NO_NODE when the parent is a root
+    std::vector<uint32_t> depths;      // 1 for children of a root
+    std::vector<uint32_t> nodeOf;      // Node of each entity index, NO_NODE for entities without parent
+    std::vector<uint8_t> dirty;        // Whether the world transform of each node was recomputed in the last pass
+    bool sorted{true};                 // Whether the nodes are in breadth first order
+    Tick lastUpdate{0};                // Tick closing the last update pass
+};
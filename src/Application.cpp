@@ -2,21 +2,23 @@
 
 Application::~Application()
 {
+    // Let the step in flight finish before the world goes away
+    m_physics.World();
     delete m_physicsWorld;
 }
 
-bool Application::Input(float deltaTime) const
+bool Application::Input(float deltaTime)
 {
     // Delta time will be used for future input handling, Box2D physics handles for now
     std::ignore = deltaTime;
-    return m_inputSystem.Input(m_physicsWorld);
+    return m_inputSystem.Input(&m_physics);
 }
 
-void Application::Update(float deltaTime) const
+void Application::Update(float deltaTime)
 {
     // Delta time will be used for future updates, Box2D physics handles for now
     std::ignore = deltaTime;
-    m_physicsSystem.Update();
+    m_scheduler.Run(m_scene.m_serialSystems);
 }
 
 void Application::Render()
@@ -45,38 +47,79 @@ void Application::Loop(float targetFPS)
             m_isRunning = false;
         }
 
+        // Sync point: apply structural changes recorded while handling input
+        m_scene.FlushCommands();
+
+        // Publish the last step and start the next one on the physics thread, it runs through the
+        // rest of the frame while the systems read the published positions
         int32 velocityIterations = 6; // Iterations for velocity calculations
         int32 positionIterations = 2; // Iterations for position calculations
         float timeStep = 1.0f / 60.0f;
-        m_physicsWorld->Step(timeStep, velocityIterations, positionIterations);
+        m_physics.Step(timeStep, velocityIterations, positionIterations);
 
-        // Update the physics simulation using a fixed time step
+        // Update the physics simulation using a fixed time step. The systems of the first update run
+        // on the workers while this thread submits the frame extracted at the end of the last loop
+        bool submitted = false;
         while (accumulator >= deltaTime)
         {
-            Update(deltaTime);
+            if (!submitted)
+            {
+                m_scheduler.Start(m_scene.m_serialSystems);
+                m_renderingSystem.Submit();
+                m_scheduler.Finish();
+                submitted = true;
+            }
+            else
+            {
+                Update(deltaTime);
+            }
             accumulator -= deltaTime;
         }
+        if (!submitted)
+        {
+            m_renderingSystem.Submit();
+        }
+
+        // Sync point: apply structural changes recorded by the systems and trigger callbacks
+        m_scene.FlushCommands();
+
+        // Move the children of the entities that moved this frame, then reindex what moved
+        m_scene.UpdateHierarchy();
+        m_scene.UpdateSpatialIndex();
+
+        // Amortized maintenance: keep one storage per frame in screen order
+        if (m_scene.m_spatialSort)
+        {
+            m_scene.SpatialSortStep();
+        }
 
-        // Render the scene
+        // Render the editor around the submitted frame, then copy this frame for the next submit
         Render();
+        m_renderingSystem.Extract();
     }
 }
 
 void Application::AddBox2D(const EntityID &entity, const float x, const float y, const float width, const float height, const bool isStatic, const bool isTrigger)
 {
     // Assign a box2d body to the entity
-    m_scene.AddBox2DCollider(entity, isStatic, isTrigger, x / m_board->m_tileSize, y / m_board->m_tileSize, width, height, m_physicsWorld);
+    m_scene.AddBox2DCollider(entity, isStatic, isTrigger, x / m_board->m_tileSize, y / m_board->m_tileSize, width, height, m_physics.World());
 }
 
 void Application::AddSprite(const EntityID &entity, const std::string filePath, const float width, const float height)
 {
-    // Assign sprite component
-    SpriteComponent *sprite = m_scene.Assign<SpriteComponent>(entity);
-    sprite->filePath = filePath;
-    sprite->width = width;
-    sprite->height = height;
-    auto sprite_texture = ResourceManager::Instance().LoadTexture(m_renderingSystem.GetSDLLayer()->GetRenderer(), sprite->filePath);
-    sprite->texture = sprite_texture;
+    // Assign sprite component, entities with the same sprite share one copy of it
+    SpriteComponent sprite;
+    sprite.filePath = filePath;
+    sprite.width = width;
+    sprite.height = height;
+    auto sprite_texture = ResourceManager::Instance().LoadTexture(m_renderingSystem.GetSDLLayer()->GetRenderer(), sprite.filePath);
+    sprite.texture = sprite_texture;
+    m_scene.AssignShared(entity, sprite);
+
+    // Sprites are drawn from the transform position, so their size is also their picking bounds
+    BoundsComponent *bounds = m_scene.Assign<BoundsComponent>(entity);
+    bounds->width = width * m_board->m_tileSize;
+    bounds->height = height * m_board->m_tileSize;
 }
 
 void Application::ImportSpritesheetLevel(const std::string levelPath, const std::string spritesheetPath)
@@ -84,20 +127,19 @@ void Application::ImportSpritesheetLevel(const std::string levelPath, const std:
     EntityID entity = m_scene.NewEntity();
     m_scene.Assign<SpriteSheetComponent>(entity);
 
-    // set up spritesheet
-    SpriteSheetComponent *sheetLocal = m_scene.Get<SpriteSheetComponent>(entity);
-    sheetLocal->spriteSheet = new SpriteSheet(levelPath, m_board, m_renderingSystem.GetSDLLayer()->GetRenderer(), spritesheetPath);
+    // set up spritesheet, it lives as long as the level
+    SpriteSheetComponent *sheetLocal = m_scene.GetMut<SpriteSheetComponent>(entity);
+    sheetLocal->spriteSheet = m_scene.arena.New<SpriteSheet>(levelPath, m_board, m_renderingSystem.GetSDLLayer()->GetRenderer(), spritesheetPath);
     auto tiles = sheetLocal->spriteSheet->GetTileIds();
     sheetLocal->importedSheet = true;
 
-    // for each tile add an entity
-    for (size_t i = 0; i < tiles.size(); i++)
-    {
-        if (tiles.at(i) != -1)
-        {
-            int x = i % m_board->m_boardWidth; // Calculate x position
-            int y = i / m_board->m_boardWidth; // Calculate y position
-            m_scene.CreateSpriteSheetTile(x, y, m_physicsWorld, m_board);
-        }
-    }
-}
\ No newline at end of file
+    // add an entity for each tile in one bulk operation
+    m_scene.CreateSpriteSheetTiles(tiles, m_physics.World(), m_board);
+}
+
+void Application::UnloadLevel()
+{
+    // Every body goes, so no queued impulse or stale position may refer to one
+    m_physics.Reset();
+    m_scene.UnloadLevel(m_physics.World());
+}
@@ -1,4 +1,5 @@
 #include "ImGuiLayer.hpp"
+#include "PhysicsThread.hpp"
 
 ImGuiLayer::ImGuiLayer(Scene *scene, SDL_Renderer *renderer, SDL_Window *window, Board *board)
     : m_scene(scene), m_renderer(renderer), m_window(window), m_board(board)
@@ -104,6 +105,14 @@ void ImGuiLayer::PreDraw(bool showDebug, SDL_Texture *m_viewportTexture)
             {
                 m_scene->m_showGrid = !m_scene->m_showGrid;
             }
+            if (ImGui::MenuItem("Spatially Sort Storage", "", m_scene->m_spatialSort))
+            {
+                m_scene->m_spatialSort = !m_scene->m_spatialSort;
+            }
+            if (ImGui::MenuItem("Run Systems Serially", "", m_scene->m_serialSystems))
+            {
+                m_scene->m_serialSystems = !m_scene->m_serialSystems;
+            }
             ImGui::EndMenu();
         }
 
@@ -188,16 +197,15 @@ void ImGuiLayer::DisplaySceneHierarchy()
 {
     ImGui::Begin("Scene Hierarchy");
     ImGuiIO &io = ImGui::GetIO();
-    for (EntityID ent : SceneView<>(*m_scene))
+    m_children.clear();
+    for (size_t node = 0; node < m_scene->hierarchy.entities.size(); node++)
     {
-        TransformComponent *transform = m_scene->Get<TransformComponent>(ent);
-
-        if (transform && transform->hasParent)
-        {
-            // Skip rendering this entity
-            continue;
-        }
+        m_children[m_scene->hierarchy.parents[node]].push_back(m_scene->hierarchy.entities[node]);
+    }
 
+    // Child entities are filtered out by the query and shown below their parent
+    for (EntityID ent : SceneView<Without<ChildTag>, Without<ParentComponent>>(*m_scene))
+    {
         DisplayEntity(ent);
     }
 
@@ -215,6 +223,17 @@ void ImGuiLayer::DisplayEntity(const EntityID &entityID)
     {
         m_scene->m_selectedEntity = entityID;
     }
+
+    auto children = m_children.find(entityID);
+    if (children != m_children.end())
+    {
+        ImGui::Indent();
+        for (EntityID child : children->second)
+        {
+            DisplayEntity(child);
+        }
+        ImGui::Unindent();
+    }
 }
 
 void ImGuiLayer::DisplayEntityProperties()
@@ -228,25 +247,62 @@ void ImGuiLayer::DisplayEntityProperties()
 
     ImGui::Begin("Entity Properties");
 
-    TransformComponent *transform = m_scene->Get<TransformComponent>(ent);
+    // Components are edited on copies and written back with GetMut only when a value changed
+    const TransformComponent *transform = m_scene->Get<TransformComponent>(ent);
 
-    Box2DColliderComponent *collider = m_scene->Get<Box2DColliderComponent>(ent);
-    SpriteComponent *sprite = m_scene->Get<SpriteComponent>(ent);
-    SpriteSheetComponent *spriteSheet = m_scene->Get<SpriteSheetComponent>(ent);
-    InputComponent *input = m_scene->Get<InputComponent>(ent);
-    GridSimulationComponent *grid = m_scene->Get<GridSimulationComponent>(ent);
+    const Box2DColliderComponent *collider = m_scene->Get<Box2DColliderComponent>(ent);
+    const SpriteComponent *sprite = m_scene->GetShared<SpriteComponent>(ent);
+    SpriteSheetComponent *spriteSheet = m_scene->GetMut<SpriteSheetComponent>(ent); // The tile panels edit it in place
+    const InputComponent *input = m_scene->Get<InputComponent>(ent);
+    const GridSimulationComponent *grid = m_scene->Get<GridSimulationComponent>(ent);
 
     if (transform)
     {
         if (ImGui::TreeNodeEx("Transform", ImGuiTreeNodeFlags_DefaultOpen, "Transform"))
         {
-            DisplayVec2Control("Transform", transform->x, transform->y);
-            ImGui::Text("Has Parent: %s", transform->hasParent ? "true" : "false");
+            const ParentComponent *parent = m_scene->Get<ParentComponent>(ent);
+            float x = transform->x;
+            float y = transform->y;
+            if (parent)
+            {
+                // The world position of a child follows its parent, so edit its offset instead
+                const LocalTransformComponent *local = m_scene->Get<LocalTransformComponent>(ent);
+                float localX = local->x;
+                float localY = local->y;
+                ImGui::Text("Parent: %llu", (unsigned long long)parent->parent);
+                DisplayVec2Control("Local", localX, localY);
+                if (localX != local->x || localY != local->y)
+                {
+                    LocalTransformComponent *edited = m_scene->GetMut<LocalTransformComponent>(ent);
+                    edited->x = localX;
+                    edited->y = localY;
+                }
+            }
+            else
+            {
+                DisplayVec2Control("Transform", x, y);
+            }
 
-            if (collider)
+            if (transform->x != x || transform->y != y)
             {
-                // Manually set the position of the collider
-                collider->body->SetTransform(b2Vec2(transform->x / m_board->m_tileSize, transform->y / m_board->m_tileSize), 0.0f);
+                TransformComponent *edited = m_scene->GetMut<TransformComponent>(ent);
+                edited->x = x;
+                edited->y = y;
+
+                if (collider)
+                {
+                    // Manually set the position of the collider, the move reaches a stepping world before its next step
+                    Box2DColliderComponent *moved = m_scene->GetMut<Box2DColliderComponent>(ent);
+                    moved->position = b2Vec2(x / m_board->m_tileSize, y / m_board->m_tileSize);
+                    if (m_scene->physics)
+                    {
+                        m_scene->physics->SetTransform(moved->body, moved->position);
+                    }
+                    else
+                    {
+                        moved->body->SetTransform(moved->position, 0.0f);
+                    }
+                }
             }
 
             ImGui::TreePop();
@@ -258,7 +314,9 @@ void ImGuiLayer::DisplayEntityProperties()
         if (ImGui::TreeNodeEx("Box2D Collider", ImGuiTreeNodeFlags_DefaultOpen, "Box2D Collider"))
         {
             // Display the position, scale,
-            ImGui::Text("Position: (%.2f, %.2f)", collider->body->GetPosition().x, collider->body->GetPosition().y);
+            ImGui::Text("Position: (%.2f, %.2f)", collider->position.x, collider->position.y);
+            ImGui::Text("Size: (%.2f, %.2f)", 2 * collider->halfExtents.x, 2 * collider->halfExtents.y);
+            ImGui::Text("%s%s", collider->isStatic ? "Static" : "Dynamic", collider->isTrigger ? " trigger" : "");
             ImGui::TreePop();
         }
     }
@@ -268,7 +326,15 @@ void ImGuiLayer::DisplayEntityProperties()
         if (ImGui::TreeNodeEx("Sprite", ImGuiTreeNodeFlags_DefaultOpen, "Sprite"))
         {
             ImGui::Text("File Path: %s", sprite->filePath.c_str());
-            DisplayVec2Control("Size", sprite->width, sprite->height, 1);
+            ImGui::Text("Shared By: %u entities", m_scene->Get<Shared<SpriteComponent>>(ent)->UseCount());
+
+            // The sprite is shared, so an edit gives this entity its own value
+            SpriteComponent edited = *sprite;
+            DisplayVec2Control("Size", edited.width, edited.height, 1);
+            if (!(edited == *sprite))
+            {
+                m_scene->AssignShared(ent, edited);
+            }
             ImGui::TreePop();
         }
     }
@@ -313,19 +379,19 @@ void ImGuiLayer::DisplayEntityProperties()
             // Button for SAND particle type
             if (ImGui::Button("Sand"))
             {
-                grid->brushType = ParticleType::SAND;
+                m_scene->GetMut<GridSimulationComponent>(ent)->brushType = ParticleType::SAND;
             }
 
             // Button for WATER particle type
             if (ImGui::Button("Water"))
             {
-                grid->brushType = ParticleType::WATER;
+                m_scene->GetMut<GridSimulationComponent>(ent)->brushType = ParticleType::WATER;
             }
 
             // Button for STONE particle type
             if (ImGui::Button("Stone"))
             {
-                grid->brushType = ParticleType::STONE;
+                m_scene->GetMut<GridSimulationComponent>(ent)->brushType = ParticleType::STONE;
             }
 
             ImGui::TreePop();
@@ -361,7 +427,7 @@ void ImGuiLayer::DisplayTileImport(SpriteSheetComponent *sheetLocal)
         try
         {
             int tile_size_int = std::stoi(tile_size);
-            sheetLocal->spriteSheet = new SpriteSheet(file_path, tile_size_int);
+            sheetLocal->spriteSheet = m_scene->arena.New<SpriteSheet>(file_path, tile_size_int);
             sheetLocal->spriteSheet->Import(m_board, m_renderer);
 
             sheetLocal->tileMapSizeError = false;
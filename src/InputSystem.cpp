@@ -1,18 +1,26 @@
 #include "InputSystem.hpp"
 
-bool InputSystem::Input(b2World *physicsWorld) const
+bool InputSystem::Input(PhysicsThread *physics)
+{
+    bool running = Poll();
+    Apply(physics);
+    return running;
+}
+
+bool InputSystem::Poll()
 {
     // Poll and handle events (inputs, window resize, etc.)
     // You can read the io.WantCaptureMouse, io.WantCaptureKeyboard flags to tell if dear imgui wants to use your inputs.
     // - When io.WantCaptureMouse is true, do not dispatch mouse input data to your main application, or clear/overwrite your copy of the mouse data.
     // - When io.WantCaptureKeyboard is true, do not dispatch keyboard input data to your main application, or clear/overwrite your copy of the keyboard data.
     // Generally you may always pass all inputs to dear imgui, and hide them from your application based on those two flags.
+    // Events stay in SDL's queue while the ring is full, so none is lost before Apply catches up.
     SDL_Event event;
-    bool isMouseDown = false;
-    while (SDL_PollEvent(&event))
+    while (!m_events.Full() && SDL_PollEvent(&event))
     {
         ImGui_ImplSDL3_ProcessEvent(&event);
 
+        InputEvent input{event.common.timestamp, 0, InputEventKind::KEY_DOWN};
         switch (event.type)
         {
         case SDL_EVENT_QUIT:
@@ -24,109 +32,123 @@ bool InputSystem::Input(b2World *physicsWorld) const
             }
             break;
         case SDL_EVENT_MOUSE_BUTTON_UP:
-            isMouseDown = false;
+            input.kind = InputEventKind::MOUSE_UP;
+            m_events.Push(input);
             break;
         case SDL_EVENT_MOUSE_BUTTON_DOWN:
-            isMouseDown = true;
+            input.kind = InputEventKind::MOUSE_DOWN;
+            m_events.Push(input);
             break;
         case SDL_EVENT_KEY_DOWN:
-            if (event.key.keysym.sym == SDLK_a)
-            {
-                for (EntityID ent : SceneView<InputComponent>(*m_scene))
-                {
-                    InputComponent *inputLocal = m_scene->Get<InputComponent>(ent);
-                    inputLocal->leftPress = true;
-                }
-            }
-            if (event.key.keysym.sym == SDLK_d)
-            {
-                for (EntityID ent : SceneView<InputComponent>(*m_scene))
-                {
-                    InputComponent *inputLocal = m_scene->Get<InputComponent>(ent);
-                    inputLocal->rightPress = true;
-                }
-            }
-            if (event.key.keysym.sym == SDLK_SPACE)
-            {
-                for (EntityID ent : SceneView<InputComponent>(*m_scene))
-                {
-                    InputComponent *inputLocal = m_scene->Get<InputComponent>(ent);
-                    inputLocal->spacePress = true;
-                }
-            }
-            else
-            {
-                for (EntityID ent : SceneView<InputComponent>(*m_scene))
-                {
-                    InputComponent *inputLocal = m_scene->Get<InputComponent>(ent);
-                    inputLocal->spacePress = false;
-                }
-            }
-
+            input.key = event.key.keysym.sym;
+            m_events.Push(input);
             break;
         case SDL_EVENT_KEY_UP:
-            if (event.key.keysym.sym == SDLK_a)
-            {
-                for (EntityID ent : SceneView<InputComponent>(*m_scene))
-                {
-                    InputComponent *inputLocal = m_scene->Get<InputComponent>(ent);
-                    inputLocal->leftPress = false;
-                }
-            }
-            if (event.key.keysym.sym == SDLK_d)
-            {
-                for (EntityID ent : SceneView<InputComponent>(*m_scene))
-                {
-                    InputComponent *inputLocal = m_scene->Get<InputComponent>(ent);
-                    inputLocal->rightPress = false;
-                }
-            }
+            input.key = event.key.keysym.sym;
+            input.kind = InputEventKind::KEY_UP;
+            m_events.Push(input);
             break;
         }
-        if (isMouseDown)
+    }
+    return true;
+}
+
+void InputSystem::Apply(PhysicsThread *physics)
+{
+    // Fold every queued event into the frame's actions before touching the scene
+    m_actions.BeginFrame();
+    InputEvent event;
+    while (m_events.Pop(event))
+    {
+        m_actions.Apply(event);
+    }
+
+    // One pass over the input components, writing only the actions an event touched so values set from scripts stay
+    const uint32_t movement = (1u << ACTION_LEFT) | (1u << ACTION_RIGHT) | (1u << ACTION_JUMP);
+    uint32_t changed = m_actions.changed & movement;
+    if (changed)
+    {
+        bool left = ActionState::Has(m_actions.held, ACTION_LEFT);
+        bool right = ActionState::Has(m_actions.held, ACTION_RIGHT);
+        bool jump = ActionState::Has(m_actions.held, ACTION_JUMP);
+        for (auto [ent, inputLocal] : SceneView<Mut<InputComponent>>(*m_scene).each())
         {
-            // Check if there is a selected entity, and the mouse is inside the viewport
-            if (m_scene->m_selectedEntity == static_cast<unsigned long long>(-1) ||
-                m_imguiLayer->viewportMousePos.x < 0 ||
-                m_imguiLayer->viewportMousePos.y < 0 ||
-                m_imguiLayer->viewportMousePos.x > m_board->m_boardWidth * m_board->m_tileSize ||
-                m_imguiLayer->viewportMousePos.y > m_board->m_boardHeight * m_board->m_tileSize)
+            if (ActionState::Has(changed, ACTION_LEFT))
+            {
+                inputLocal.leftPress = left;
+            }
+            if (ActionState::Has(changed, ACTION_RIGHT))
             {
-                break;
+                inputLocal.rightPress = right;
             }
-            else
+            if (ActionState::Has(changed, ACTION_JUMP))
             {
-                // Chevk if the entity has a GridSimulationComponent
-                GridSimulationComponent *grid = m_scene->Get<GridSimulationComponent>(m_scene->m_selectedEntity);
-                // Check if the entity has a SpriteSheetComponent (this is the only mouse input we handle now)
-                SpriteSheetComponent *sheetLocal = m_scene->Get<SpriteSheetComponent>(m_scene->m_selectedEntity);
-                if (!sheetLocal && !grid)
-                {
-                    break;
-                }
+                inputLocal.spacePress = jump;
+            }
+        }
+    }
 
-                if (grid)
-                {
-                    float scale = 2.0f; // Scale factor (adjust as needed)
+    // Painting runs once per frame while the button is down, however many mouse events arrived
+    bool pressed = ActionState::Has(m_actions.pressed, ACTION_PAINT);
+    if (pressed || ActionState::Has(m_actions.held, ACTION_PAINT))
+    {
+        Paint(physics, pressed);
+    }
+}
 
-                    int gridPositionX = m_imguiLayer->viewportMousePos.x / scale;
-                    int gridPositionY = m_imguiLayer->viewportMousePos.y / scale;
-                    if (gridPositionX < 0 || gridPositionY < 0 || gridPositionX > grid->cols || gridPositionY > grid->rows)
-                    {
-                        break;
-                    }
-                    grid->UpdateCircle(gridPositionX, gridPositionY);
-                }
+void InputSystem::Paint(PhysicsThread *physics, bool pressed)
+{
+    // Check the mouse is inside the viewport
+    if (m_imguiLayer->viewportMousePos.x < 0 ||
+        m_imguiLayer->viewportMousePos.y < 0 ||
+        m_imguiLayer->viewportMousePos.x > m_board->m_boardWidth * m_board->m_tileSize ||
+        m_imguiLayer->viewportMousePos.y > m_board->m_boardHeight * m_board->m_tileSize)
+    {
+        return;
+    }
 
-                if (sheetLocal && sheetLocal->importedSheet)
-                {
-                    int gridPositionX = m_imguiLayer->viewportMousePos.x / m_board->m_tileSize;
-                    int gridPositionY = m_imguiLayer->viewportMousePos.y / m_board->m_tileSize;
-                    sheetLocal->spriteSheet->AddTileId(sheetLocal->selectedTileId, gridPositionX, gridPositionY);
-                    m_scene->CreateSpriteSheetTile(gridPositionX, gridPositionY, physicsWorld, m_board);
-                }
-            }
+    // Nothing to paint with until an entity is selected, Get does not bounds check the id
+    GridSimulationComponent *grid = nullptr;
+    const SpriteSheetComponent *sheetLocal = nullptr;
+    if (m_scene->m_selectedEntity != static_cast<unsigned long long>(-1))
+    {
+        // Chevk if the entity has a GridSimulationComponent
+        grid = m_scene->GetMut<GridSimulationComponent>(m_scene->m_selectedEntity);
+        // Check if the entity has a SpriteSheetComponent
+        sheetLocal = m_scene->Get<SpriteSheetComponent>(m_scene->m_selectedEntity);
+    }
+    if (!sheetLocal && !grid)
+    {
+        // Otherwise the click selects the entity under the mouse
+        EntityID picked = pressed ? m_scene->spatialIndex.Pick(m_imguiLayer->viewportMousePos.x, m_imguiLayer->viewportMousePos.y) : EntityID(-1);
+        if (picked != EntityID(-1))
+        {
+            m_scene->m_selectedEntity = picked;
         }
+        return;
+    }
+
+    if (grid)
+    {
+        float scale = 2.0f; // Scale factor (adjust as needed)
+
+        int gridPositionX = m_imguiLayer->viewportMousePos.x / scale;
+        int gridPositionY = m_imguiLayer->viewportMousePos.y / scale;
+        if (gridPositionX < 0 || gridPositionY < 0 || gridPositionX > grid->cols || gridPositionY > grid->rows)
+        {
+            return;
+        }
+        grid->UpdateCircle(gridPositionX, gridPositionY);
+    }
+
+    // A tile is placed once per click, holding the button would stack bodies on the same cell
+    if (sheetLocal && sheetLocal->importedSheet && pressed)
+    {
+        int gridPositionX = m_imguiLayer->viewportMousePos.x / m_board->m_tileSize;
+        int gridPositionY = m_imguiLayer->viewportMousePos.y / m_board->m_tileSize;
+        sheetLocal->spriteSheet->AddTileId(sheetLocal->selectedTileId, gridPositionX, gridPositionY);
+
+        // Only painting a tile waits for the step in flight, to add its body
+        m_scene->CreateSpriteSheetTile(gridPositionX, gridPositionY, physics->World(), m_board);
     }
-    return true;
 }
\ No newline at end of file
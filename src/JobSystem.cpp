@@ -0,0 +1,138 @@
+#include "JobSystem.hpp"
+
+namespace
+{
+    // Deque of the calling thread, 0 for threads outside the pool
+    thread_local size_t t_queueIndex = 0;
+    thread_local const JobSystem *t_owner = nullptr;
+}
+
+size_t JobSystem::DefaultWorkerCount()
+{
+    unsigned int threads = std::thread::hardware_concurrency();
+    return threads > 1 ? threads - 1 : 0;
+}
+
+JobSystem::JobSystem(size_t workerCount)
+{
+    for (size_t i = 0; i < workerCount + 1; i++)
+    {
+        m_queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (size_t i = 0; i < workerCount; i++)
+    {
+        m_workers.emplace_back(&JobSystem::WorkerLoop, this, i + 1);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (std::thread &worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+void JobSystem::Submit(Job job, JobCounter &counter)
+{
+    counter.pending++;
+
+    // Counted first, under the sleep mutex, so a worker going to sleep cannot miss it
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_queued++;
+    }
+    size_t queueIndex = t_owner == this ? t_queueIndex : 0;
+    {
+        std::lock_guard<std::mutex> lock(m_queues[queueIndex]->mutex);
+        m_queues[queueIndex]->tasks.push_back({std::move(job), &counter});
+    }
+    m_wake.notify_one();
+}
+
+bool JobSystem::Take(Task &task)
+{
+    if (m_queued.load() == 0)
+    {
+        return false;
+    }
+
+    // Newest job of the own deque first, it is likely still in cache
+    size_t own = t_owner == this ? t_queueIndex : 0;
+    {
+        WorkQueue &queue = *m_queues[own];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty())
+        {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            m_queued--;
+            return true;
+        }
+    }
+
+    // Then the oldest job of another deque, starting after our own to spread the thieves
+    for (size_t i = 1; i < m_queues.size(); i++)
+    {
+        WorkQueue &queue = *m_queues[(own + i) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty())
+        {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            m_queued--;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool JobSystem::RunPending()
+{
+    Task task;
+    if (!Take(task))
+    {
+        return false;
+    }
+    task.job();
+    task.counter->pending--;
+    return true;
+}
+
+void JobSystem::Wait(JobCounter &counter)
+{
+    while (counter.pending.load() != 0)
+    {
+        if (!RunPending())
+        {
+            // The remaining jobs are running on other threads
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::WorkerLoop(size_t queueIndex)
+{
+    t_queueIndex = queueIndex;
+    t_owner = this;
+    while (true)
+    {
+        if (RunPending())
+        {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wake.wait(lock, [this]
+                    { return m_stopping || m_queued.load() != 0; });
+        if (m_stopping && m_queued.load() == 0)
+        {
+            return;
+        }
+    }
+}
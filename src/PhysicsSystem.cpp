@@ -1,32 +1,60 @@
 #include "PhysicsSystem.hpp"
+#include "PhysicsThread.hpp"
 
-void PhysicsSystem::Update() const
+void PhysicsSystem::Register(SystemScheduler &scheduler) const
 {
-    // Update transforms based on physics simulation
-    UpdateTransforms();
-
-    // Handle player movement
-    HandlePlayerMovement();
-
-    // Check for collisions
-    CheckTriggers();
+    // Every pass touching bodies writes the colliders, so those run in order while the grids run beside them
+    scheduler.Add({"UpdateTransforms", [this]
+                   { UpdateTransforms(); },
+                   ComponentMask(), SystemScheduler::Mask<TransformComponent, Box2DColliderComponent>()});
+    scheduler.Add({"UpdateGrids", [this]
+                   { UpdateGrids(); },
+                   ComponentMask(), SystemScheduler::Mask<GridSimulationComponent>()});
+    scheduler.Add({"HandlePlayerMovement", [this]
+                   { HandlePlayerMovement(); },
+                   ComponentMask(), SystemScheduler::Mask<TransformComponent, InputComponent, Box2DColliderComponent>()});
+
+    // Trigger callbacks are Python functions that may touch anything
+    scheduler.Add({"CheckTriggers", [this]
+                   { CheckTriggers(); },
+                   SystemScheduler::Mask<Box2DColliderComponent, CollisionCallbackComponent, TriggerTag>(), ComponentMask(), true, true});
 }
 
 void PhysicsSystem::UpdateTransforms() const
 {
-    for (EntityID ent : SceneView<TransformComponent, Box2DColliderComponent>(*m_scene))
-    {
-        TransformComponent *transformLocal = m_scene->Get<TransformComponent>(ent);
-        Box2DColliderComponent *boxColliderLocal = m_scene->Get<Box2DColliderComponent>(ent);
+    // The group keeps transforms and colliders side by side, so every job walks the same slice of both pools.
+    // Positions come from the snapshot of the last finished step, the world itself may be stepping
+    const PhysicsThread *physics = m_scene->physics;
+    Group<TransformComponent, Box2DColliderComponent>(*m_scene).par_each([this, physics](EntityID ent, const TransformComponent &transformLocal, const Box2DColliderComponent &boxColliderLocal)
+                                                                         {
+        // Static geometry never moves, and bodies created since the last step keep their initial position
+        b2Vec2 position;
+        if (boxColliderLocal.isStatic || !physics->GetPosition(ent, position))
+        {
+            return;
+        }
 
-        // Update the position of the entity based on the physics simulation
-        transformLocal->x = boxColliderLocal->body->GetPosition().x * m_board->m_tileSize;
-        transformLocal->y = boxColliderLocal->body->GetPosition().y * m_board->m_tileSize;
-    }
+        // Only the bodies that moved are written, the pages of resting ones stay shared with forks
+        if (boxColliderLocal.position != position)
+        {
+            m_scene->GetMut<Box2DColliderComponent>(ent)->position = position;
+        }
+        float x = position.x * m_board->m_tileSize;
+        float y = position.y * m_board->m_tileSize;
+        if (transformLocal.x != x || transformLocal.y != y)
+        {
+            TransformComponent *transform = m_scene->GetMut<TransformComponent>(ent);
+            transform->x = x;
+            transform->y = y;
+        } });
+}
 
-    for (EntityID ent : SceneView<GridSimulationComponent>(*m_scene))
+void PhysicsSystem::UpdateGrids() const
+{
+    // The grid data is owned by the component, so writing it must unshare the component from forks
+    for (auto [ent, gridLocal] : SceneView<Mut<GridSimulationComponent>>(*m_scene).each())
     {
-        GridSimulationComponent *grid = m_scene->Get<GridSimulationComponent>(ent);
+        GridSimulationComponent *grid = &gridLocal;
 
         // Update the grid simulation based on pixel physics
         // If data is 1, move tile down, if tile is occupied move to left or right
@@ -129,82 +157,82 @@ void PhysicsSystem::UpdateWater(int row, int col, GridSimulationComponent *grid,
 
 void PhysicsSystem::HandlePlayerMovement() const
 {
-    for (EntityID ent : SceneView<TransformComponent, InputComponent, Box2DColliderComponent>(*m_scene))
+    // Impulses and moves are queued for the next step, the body may be stepping right now
+    PhysicsThread *physics = m_scene->physics;
+    for (auto [ent, transformLocal, inputLocal, boxColliderLocal] : SceneView<TransformComponent, InputComponent, Box2DColliderComponent>(*m_scene).each())
     {
-        TransformComponent *transformLocal = m_scene->Get<TransformComponent>(ent);
-        InputComponent *inputLocal = m_scene->Get<InputComponent>(ent);
-        Box2DColliderComponent *boxColliderLocal = m_scene->Get<Box2DColliderComponent>(ent);
-
         // Check if the player is on the ground
-        if (inputLocal->spacePress)
+        if (inputLocal.spacePress)
         {
             // Apply a vertical impulse to simulate jumping
-            boxColliderLocal->body->ApplyLinearImpulseToCenter(b2Vec2(0, inputLocal->jumpSpeed), true);
-            inputLocal->spacePress = false;
+            physics->ApplyImpulse(boxColliderLocal.body, b2Vec2(0, inputLocal.jumpSpeed));
+            m_scene->GetMut<InputComponent>(ent)->spacePress = false;
         }
 
         // Update acceleration based on key presses
-        if (inputLocal->leftPress)
+        if (inputLocal.leftPress)
         {
-            boxColliderLocal->body->ApplyLinearImpulseToCenter(b2Vec2(-inputLocal->speed, 0), true);
+            physics->ApplyImpulse(boxColliderLocal.body, b2Vec2(-inputLocal.speed, 0));
         }
-        else if (inputLocal->rightPress)
+        else if (inputLocal.rightPress)
         {
-            boxColliderLocal->body->ApplyLinearImpulseToCenter(b2Vec2(inputLocal->speed, 0), true);
+            physics->ApplyImpulse(boxColliderLocal.body, b2Vec2(inputLocal.speed, 0));
         }
 
-        // Reset player position if out of bounds
-        if (boxColliderLocal->body->GetPosition().x < 0.0f)
+        // Reset player position if out of bounds. The last step may already be behind the body, so
+        // the clamp is queued and applied to the position the body has when the next step starts
+        b2Vec2 position = boxColliderLocal.position;
+        if (position.x < 0.0f)
         {
-            boxColliderLocal->body->SetTransform(b2Vec2(0.0f, boxColliderLocal->body->GetPosition().y), 0.0f);
+            position.x = 0.0f;
         }
 
-        if (boxColliderLocal->body->GetPosition().x >= m_board->m_boardWidth - 1)
+        if (position.x >= m_board->m_boardWidth - 1)
         {
-            boxColliderLocal->body->SetTransform(b2Vec2(m_board->m_boardWidth - 1, boxColliderLocal->body->GetPosition().y), 0.0f);
+            position.x = m_board->m_boardWidth - 1;
         }
 
-        if (boxColliderLocal->body->GetPosition().y < 0.0f)
+        if (position.y < 0.0f)
         {
-            boxColliderLocal->body->SetTransform(b2Vec2(boxColliderLocal->body->GetPosition().x, 0.0f), 0.0f);
+            position.y = 0.0f;
         }
 
-        if (boxColliderLocal->body->GetPosition().y > m_board->m_boardHeight - 1)
+        if (position.y > m_board->m_boardHeight - 1)
         {
-            boxColliderLocal->body->SetTransform(b2Vec2(boxColliderLocal->body->GetPosition().x, m_board->m_boardHeight - 1), 0.0f);
+            position.y = m_board->m_boardHeight - 1;
         }
 
-        // Update the position of the entity based on the physics simulation
-        transformLocal->x = boxColliderLocal->body->GetPosition().x * m_board->m_tileSize;
-        transformLocal->y = boxColliderLocal->body->GetPosition().y * m_board->m_tileSize;
+        if (position != boxColliderLocal.position)
+        {
+            physics->ClampPosition(boxColliderLocal.body, b2Vec2(0.0f, 0.0f), b2Vec2(m_board->m_boardWidth - 1, m_board->m_boardHeight - 1));
+        }
+
+        // Update the position of the entity based on the physics simulation, static geometry stays untouched
+        if (position != boxColliderLocal.position)
+        {
+            m_scene->GetMut<Box2DColliderComponent>(ent)->position = position;
+        }
+        float x = position.x * m_board->m_tileSize;
+        float y = position.y * m_board->m_tileSize;
+        if (transformLocal.x != x || transformLocal.y != y)
+        {
+            TransformComponent *transform = m_scene->GetMut<TransformComponent>(ent);
+            transform->x = x;
+            transform->y = y;
+        }
     }
 }
 
 void PhysicsSystem::CheckTriggers() const
 {
-    for (EntityID ent : SceneView<TransformComponent, Box2DColliderComponent>(*m_scene))
+    // Only trigger colliders match the query, their contacts are counted by the physics thread after each step
+    const PhysicsThread *physics = m_scene->physics;
+    for (auto [ent, boxColliderLocal, callbackLocal] : SceneView<Box2DColliderComponent, CollisionCallbackComponent, With<TriggerTag>>(*m_scene).each())
     {
-        Box2DColliderComponent *boxColliderLocal = m_scene->Get<Box2DColliderComponent>(ent);
-
-        if (boxColliderLocal->isTrigger)
+        // Call back once per contact with another object
+        for (uint32_t contacts = physics->GetContactCount(ent); contacts > 0; contacts--)
         {
-            // Check for collisions with other objects
-            for (b2ContactEdge *edge = boxColliderLocal->body->GetContactList(); edge; edge = edge->next)
-            {
-                b2Contact *contact = edge->contact;
-                b2Fixture *fixtureA = contact->GetFixtureA();
-                b2Fixture *fixtureB = contact->GetFixtureB();
-
-                // Iterate over all fixtures attached to the body and check for collision
-                for (b2Fixture *fixture = boxColliderLocal->body->GetFixtureList(); fixture; fixture = fixture->GetNext())
-                {
-                    if (fixture == fixtureA || fixture == fixtureB)
-                    {
-                        boxColliderLocal->OnCollisionEnter();
-                        break;
-                    }
-                }
-            }
+            callbackLocal.OnCollisionEnter();
         }
     }
 }
@@ -0,0 +1,198 @@
+#include "PhysicsThread.hpp"
+#include <algorithm>
+
+PhysicsThread::PhysicsThread(b2World *world)
+    : m_world(world), m_thread(&PhysicsThread::ThreadLoop, this)
+{
+}
+
+PhysicsThread::~PhysicsThread()
+{
+    Wait();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_condition.notify_all();
+    m_thread.join();
+}
+
+void PhysicsThread::Step(float timeStep, int32 velocityIterations, int32 positionIterations)
+{
+    Wait();
+
+    // The finished step becomes the snapshot, the next one overwrites the older buffer
+    m_front = 1 - m_front;
+    {
+        std::lock_guard<std::mutex> lock(m_commandMutex);
+        m_stepCommands.swap(m_commands);
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_timeStep = timeStep;
+        m_velocityIterations = velocityIterations;
+        m_positionIterations = positionIterations;
+        m_stepping = true;
+    }
+    m_condition.notify_all();
+}
+
+b2World *PhysicsThread::World()
+{
+    Wait();
+    return m_world;
+}
+
+void PhysicsThread::ApplyImpulse(b2Body *body, const b2Vec2 &impulse)
+{
+    std::lock_guard<std::mutex> lock(m_commandMutex);
+    m_commands.push_back({body, impulse, b2Vec2_zero, CommandKind::IMPULSE});
+}
+
+void PhysicsThread::SetTransform(b2Body *body, const b2Vec2 &position)
+{
+    std::lock_guard<std::mutex> lock(m_commandMutex);
+    m_commands.push_back({body, position, b2Vec2_zero, CommandKind::TELEPORT});
+}
+
+void PhysicsThread::ClampPosition(b2Body *body, const b2Vec2 &lower, const b2Vec2 &upper)
+{
+    std::lock_guard<std::mutex> lock(m_commandMutex);
+    m_commands.push_back({body, lower, upper, CommandKind::CLAMP});
+}
+
+void PhysicsThread::DestroyBody(b2Body *body)
+{
+    Wait();
+    {
+        std::lock_guard<std::mutex> lock(m_commandMutex);
+        m_commands.erase(std::remove_if(m_commands.begin(), m_commands.end(), [body](const BodyCommand &command)
+                                        { return command.body == body; }),
+                         m_commands.end());
+    }
+
+    // Neither snapshot may report the body once it is gone, its entity can get another one
+    EntityID entity = EntityID(body->GetUserData().pointer);
+    size_t index = size_t(entity >> 32);
+    for (std::vector<BodyState> &states : m_states)
+    {
+        if (index < states.size() && states[index].entity == entity)
+        {
+            states[index] = BodyState();
+        }
+    }
+    m_world->DestroyBody(body);
+}
+
+void PhysicsThread::Reset()
+{
+    Wait();
+    {
+        std::lock_guard<std::mutex> lock(m_commandMutex);
+        m_commands.clear();
+    }
+    m_states[0].clear();
+    m_states[1].clear();
+}
+
+bool PhysicsThread::GetPosition(EntityID entity, b2Vec2 &position) const
+{
+    const BodyState *pState = Find(entity);
+    if (!pState)
+    {
+        return false;
+    }
+    position = pState->position;
+    return true;
+}
+
+uint32_t PhysicsThread::GetContactCount(EntityID entity) const
+{
+    const BodyState *pState = Find(entity);
+    return pState ? pState->contacts : 0;
+}
+
+const PhysicsThread::BodyState *PhysicsThread::Find(EntityID entity) const
+{
+    // Same split as Scene::GetEntityIndex
+    size_t index = size_t(entity >> 32);
+    const std::vector<BodyState> &states = m_states[m_front];
+    if (index >= states.size() || states[index].entity != entity)
+    {
+        return nullptr;
+    }
+    return &states[index];
+}
+
+void PhysicsThread::Wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_condition.wait(lock, [this]
+                     { return !m_stepping; });
+}
+
+void PhysicsThread::RunStep()
+{
+    for (const BodyCommand &command : m_stepCommands)
+    {
+        switch (command.kind)
+        {
+        case CommandKind::IMPULSE:
+            command.body->ApplyLinearImpulseToCenter(command.value, true);
+            break;
+        case CommandKind::TELEPORT:
+            command.body->SetTransform(command.value, 0.0f);
+            break;
+        case CommandKind::CLAMP:
+        {
+            // Clamped against the position the last step reached, not the one the systems saw
+            b2Vec2 position = b2Clamp(command.body->GetPosition(), command.value, command.upper);
+            if (position != command.body->GetPosition())
+            {
+                command.body->SetTransform(position, 0.0f);
+            }
+            break;
+        }
+        }
+    }
+    m_stepCommands.clear();
+
+    m_world->Step(m_timeStep, m_velocityIterations, m_positionIterations);
+
+    // Every body is written, static ones included, so no slot keeps the contacts of an older step
+    std::vector<BodyState> &states = m_states[1 - m_front];
+    for (b2Body *body = m_world->GetBodyList(); body; body = body->GetNext())
+    {
+        EntityID entity = EntityID(body->GetUserData().pointer);
+        size_t index = size_t(entity >> 32);
+        if (index >= states.size())
+        {
+            states.resize(index + 1);
+        }
+        uint32_t contacts = 0;
+        for (b2ContactEdge *edge = body->GetContactList(); edge; edge = edge->next)
+        {
+            contacts++;
+        }
+        states[index] = {entity, body->GetPosition(), contacts};
+    }
+}
+
+void PhysicsThread::ThreadLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_condition.wait(lock, [this]
+                         { return m_stepping || m_stop; });
+        if (m_stop)
+        {
+            return;
+        }
+        lock.unlock();
+        RunStep();
+        lock.lock();
+        m_stepping = false;
+        m_condition.notify_all();
+    }
+}
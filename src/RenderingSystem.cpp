@@ -9,82 +9,124 @@ void RenderingSystem::Render()
 
 SDL_Texture *RenderingSystem::GetWindowTexture()
 {
-    if (m_viewportTexture)
+    if (!m_viewportTexture)
     {
-        // Free the texture if it already exists
-        SDL_DestroyTexture(m_viewportTexture);
+        // Create an SDL Texture for ImGui, Submit draws into it
+        m_viewportTexture = SDL_CreateTexture(m_sdlLayer->GetRenderer(), SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+                                              m_board->m_boardWidth * m_board->m_tileSize, m_board->m_boardHeight * m_board->m_tileSize);
     }
-    // Step 1: Create an SDL Texture for ImGui
-    m_viewportTexture = SDL_CreateTexture(m_sdlLayer->GetRenderer(), SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
-                                          m_board->m_boardWidth * m_board->m_tileSize, m_board->m_boardHeight * m_board->m_tileSize);
-
-    // Step 2: Set the texture as the render target
-    SDL_SetRenderTarget(m_sdlLayer->GetRenderer(), m_viewportTexture);
-    SDL_RenderClear(m_sdlLayer->GetRenderer());
-
-    // Step 3: Call all SDL rendering functions
-    SDLRender(m_scene->m_showColliders);
-    if (m_scene->m_showGrid)
-    {
-        m_board->Render(m_sdlLayer->GetRenderer());
-    }
-
-    // Step 4: Reset the render target to the window
-    SDL_SetRenderTarget(m_sdlLayer->GetRenderer(), NULL);
-
     return m_viewportTexture;
 }
 
-void RenderingSystem::SDLRender(bool &showColliders) const
+void RenderingSystem::Extract()
 {
-    // Render the sprites
-    for (EntityID ent : SceneView<SpriteComponent, TransformComponent>(*m_scene))
+    RenderPacket &packet = m_packets.Back();
+    packet.Clear();
+    packet.showGrid = m_scene->m_showGrid;
+
+    // Copy the sprites, one shared sprite value at a time so each texture is drawn in a row
+    for (auto &group : m_spriteGroups.Refresh())
     {
-        TransformComponent *transformLocal = m_scene->Get<TransformComponent>(ent);
-        SpriteComponent *spriteLocal = m_scene->Get<SpriteComponent>(ent);
-        m_sdlLayer->DrawTexture(spriteLocal->texture.get(), transformLocal->x, transformLocal->y, spriteLocal->width * m_board->m_tileSize, spriteLocal->height * m_board->m_tileSize);
+        const SpriteComponent &spriteLocal = *group.value;
+        for (auto [ent, sprite, transformLocal] : group.items)
+        {
+            DrawCommand command;
+            command.texture = spriteLocal.texture.get();
+            command.dst = {transformLocal.x, transformLocal.y, spriteLocal.width * m_board->m_tileSize, spriteLocal.height * m_board->m_tileSize};
+            command.layer = SPRITE_LAYER;
+            packet.commands.push_back(command);
+        }
     }
 
-    // Render the sprite sheets
-    for (EntityID ent : SceneView<SpriteSheetComponent>(*m_scene))
+    // Copy the sprite sheets
+    for (auto [ent, sheetLocal] : SceneView<SpriteSheetComponent>(*m_scene).each())
     {
-        SpriteSheetComponent *sheetLocal = m_scene->Get<SpriteSheetComponent>(ent);
-        if (sheetLocal->importedSheet)
+        if (sheetLocal.importedSheet)
         {
-            sheetLocal->spriteSheet->Render(m_sdlLayer);
+            sheetLocal.spriteSheet->Extract(packet);
         }
     }
 
-    for (EntityID ent : SceneView<GridSimulationComponent>(*m_scene))
+    for (auto [ent, grid] : SceneView<GridSimulationComponent>(*m_scene).each())
     {
-        GridSimulationComponent *grid = m_scene->Get<GridSimulationComponent>(ent);
-
-        // Render the grid 
-        m_sdlLayer->DrawGrid(grid->rows, grid->cols, grid->gridData);
+        // Copy the cell colors, the grid simulation keeps updating the particles during Submit
+        DrawCommand command;
+        command.kind = DrawKind::GRID;
+        command.dst = {0, 0, float(grid.cols), float(grid.rows)};
+        command.layer = GRID_LAYER;
+        command.firstCell = uint32_t(packet.cells.size());
+        packet.commands.push_back(command);
+        for (const particle_t &particle : *grid.gridData)
+        {
+            packet.cells.push_back(particle.color);
+        }
     }
 
-    if (showColliders)
+    if (m_scene->m_showColliders)
     {
-        for (EntityID ent : SceneView<Box2DColliderComponent>(*m_scene))
+        for (auto [ent, box2d] : SceneView<Box2DColliderComponent>(*m_scene).each())
         {
-            Box2DColliderComponent *box2d = m_scene->Get<Box2DColliderComponent>(ent);
+            // Calculate the position and size for rendering in pixels from the synced body position
+            DrawCommand command;
+            command.kind = DrawKind::RECTANGLE;
+            command.dst.x = box2d.position.x * m_board->m_tileSize;
+            command.dst.y = box2d.position.y * m_board->m_tileSize;
+            command.dst.w = 2 * box2d.halfExtents.x * m_board->m_tileSize;
+            command.dst.h = 2 * box2d.halfExtents.y * m_board->m_tileSize;
+
+            // Determine the color based on trigger status
+            command.color = box2d.isTrigger ? SDL_Color{0, 255, 255, 255} : SDL_Color{255, 255, 0, 255};
+            command.layer = COLLIDER_LAYER;
+            packet.commands.push_back(command);
+        }
+    }
 
-            // Get the body's position
-            b2Vec2 position = box2d->body->GetPosition();
+    packet.SortByLayer();
+    m_packets.Publish();
+}
 
-            b2AABB aabb = box2d->body->GetFixtureList()->GetAABB(0); // Get the shape's AABB
+void RenderingSystem::Submit()
+{
+    const RenderPacket &packet = m_packets.Acquire();
 
-            // Calculate the position and size for rendering in pixels
-            float renderX = position.x * m_board->m_tileSize;
-            float renderY = position.y * m_board->m_tileSize;
-            float renderWidth = (aabb.upperBound.x - aabb.lowerBound.x) * m_board->m_tileSize;
-            float renderHeight = (aabb.upperBound.y - aabb.lowerBound.y) * m_board->m_tileSize;
+    // Step 1: Set the viewport texture as the render target
+    SDL_SetRenderTarget(m_sdlLayer->GetRenderer(), GetWindowTexture());
+    SDL_RenderClear(m_sdlLayer->GetRenderer());
 
-            // Determine the color based on trigger status
-            SDL_Color color = box2d->isTrigger ? SDL_Color{0, 255, 255, 255} : SDL_Color{255, 255, 0, 255};
+    // Step 2: Draw the packet, the scene is not read here
+    SDLRender(packet);
+    if (packet.showGrid)
+    {
+        m_board->Render(m_sdlLayer->GetRenderer());
+    }
+
+    // Step 3: Reset the render target to the window
+    SDL_SetRenderTarget(m_sdlLayer->GetRenderer(), NULL);
+}
 
-            // Render the rectangle at the calculated position and size
-            m_sdlLayer->DrawRectangle(renderX, renderY, renderWidth, renderHeight, color);
+void RenderingSystem::SDLRender(const RenderPacket &packet) const
+{
+    for (const DrawCommand &command : packet.commands)
+    {
+        switch (command.kind)
+        {
+        case DrawKind::TEXTURE:
+            if (command.src.w > 0)
+            {
+                m_sdlLayer->DrawTextureSample(command.texture, command.dst.x, command.dst.y, command.dst.w, command.dst.h,
+                                              command.src.x, command.src.y, command.src.w, command.src.h);
+            }
+            else
+            {
+                m_sdlLayer->DrawTexture(command.texture, command.dst.x, command.dst.y, command.dst.w, command.dst.h);
+            }
+            break;
+        case DrawKind::RECTANGLE:
+            m_sdlLayer->DrawRectangle(command.dst.x, command.dst.y, command.dst.w, command.dst.h, command.color);
+            break;
+        case DrawKind::GRID:
+            m_sdlLayer->DrawGrid(int(command.dst.h), int(command.dst.w), packet.cells.data() + command.firstCell);
+            break;
         }
     }
 }
\ No newline at end of file
@@ -1,133 +1,1249 @@
 #include "Scene.hpp"
+#include "SceneView.hpp"
+#include "PhysicsThread.hpp"
 
-int s_componentCounter = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
-template <class T>
-int Scene::GetId()
+Scene::Scene()
 {
-    static int s_componentId = s_componentCounter++;
-    return s_componentId;
+    // Every registered component has a fixed id, so all layouts are known up front
+#ifdef ECS_ARCHETYPE_STORAGE
+    componentInfos = RegisteredComponents();
+#else
+    for (size_t componentId = 0; componentId < COMPONENT_COUNT; componentId++)
+    {
+        componentPools[componentId] = new ComponentPool(RegisteredComponents()[componentId]);
+    }
+#endif
 }
 
-EntityID Scene::CreateEntityId(EntityIndex index, EntityVersion version)
+Scene::~Scene()
 {
-    // Shift the index up 32, and put the version in the bottom
-    return ((EntityID)index << 32) | ((EntityID)version);
+#ifdef ECS_ARCHETYPE_STORAGE
+    for (Archetype *archetype : archetypes)
+    {
+        delete archetype;
+    }
+#else
+    for (ComponentPool *pool : componentPools)
+    {
+        delete pool;
+    }
+    for (OwningGroup *group : groups)
+    {
+        delete group;
+    }
+#endif
+    for (SceneQuery *query : queries)
+    {
+        delete query;
+    }
+    for (CommandBuffer *buffer : commandBuffers)
+    {
+        delete buffer;
+    }
+    for (ComponentObserverBase *observer : observers)
+    {
+        delete observer;
+    }
+
+    // Released after the components so the handles can still reach their store
+    for (std::shared_ptr<SharedStoreBase> &store : sharedStores)
+    {
+        store.reset();
+    }
 }
 
-EntityIndex Scene::GetEntityIndex(EntityID id)
+template <typename... Types>
+constexpr bool AllCopyable(TypeList<Types...>)
 {
-    // Shift down 32 so we lose the version and get our index
-    return id >> 32;
+    return (true && ... && std::is_copy_constructible<Types>::value);
 }
+static_assert(AllCopyable(ComponentRegistry()), "Scene::Fork copies components, registered components must be copyable");
 
-EntityVersion Scene::GetEntityVersion(EntityID id)
+Scene *Scene::Fork(b2World *physicsWorld)
 {
-    // Cast to a 32 bit int to get our version number (loosing the top 32 bits)
-    return (EntityVersion)id;
+    Scene *fork = new Scene();
+    fork->entities = entities;
+    fork->freeEntities = freeEntities;
+    fork->changeTick = changeTick;
+    fork->sharedStores = sharedStores;
+    fork->hierarchy = hierarchy;
+    fork->spatialIndex = spatialIndex;
+    fork->spatialSortCursor = spatialSortCursor;
+    fork->m_showGrid = m_showGrid;
+    fork->m_showColliders = m_showColliders;
+    fork->m_spatialSort = m_spatialSort;
+    fork->m_serialSystems = m_serialSystems;
+    fork->jobSystem = jobSystem;
+    fork->m_selectedEntity = m_selectedEntity;
+
+#ifdef ECS_ARCHETYPE_STORAGE
+    // Chunks are copied, then every archetype pointer is translated to its copy
+    std::unordered_map<Archetype *, Archetype *> clones;
+    for (Archetype *archetype : archetypes)
+    {
+        Archetype *clone = archetype->Clone(componentInfos);
+        clones[archetype] = clone;
+        fork->archetypes.push_back(clone);
+        fork->archetypeLookup[clone->mask] = clone;
+    }
+    auto translate = [&clones](Archetype *archetype)
+    { return archetype ? clones.at(archetype) : nullptr; };
+    for (Archetype *archetype : archetypes)
+    {
+        Archetype *clone = clones[archetype];
+        std::transform(archetype->addEdges.begin(), archetype->addEdges.end(), std::back_inserter(clone->addEdges), translate);
+        std::transform(archetype->removeEdges.begin(), archetype->removeEdges.end(), std::back_inserter(clone->removeEdges), translate);
+    }
+    fork->locations = locations;
+    for (EntityLocation &location : fork->locations)
+    {
+        location.archetype = translate(location.archetype);
+    }
+#else
+    for (size_t componentId = 0; componentId < COMPONENT_COUNT; componentId++)
+    {
+        delete fork->componentPools[componentId];
+        fork->componentPools[componentId] = componentPools[componentId]->fork();
+    }
+    for (OwningGroup *group : groups)
+    {
+        OwningGroup *copy = new OwningGroup(*group);
+        for (size_t componentId = 0; componentId < COMPONENT_COUNT; componentId++)
+        {
+            if (group->owned.test(componentId))
+            {
+                fork->poolOwners[componentId] = copy;
+            }
+        }
+        std::transform(group->pools.begin(), group->pools.end(), copy->pools.begin(), [this, fork](ComponentPool *pool)
+                       { return fork->componentPools[std::find(componentPools.begin(), componentPools.end(), pool) - componentPools.begin()]; });
+        fork->groups.push_back(copy);
+    }
+#endif
+
+    for (SceneQuery *query : queries)
+    {
+        SceneQuery *copy = new SceneQuery(*query);
+#ifdef ECS_ARCHETYPE_STORAGE
+        std::transform(copy->archetypes.begin(), copy->archetypes.end(), copy->archetypes.begin(), translate);
+#endif
+        fork->queries.push_back(copy);
+        fork->queryLookup[{copy->include, copy->exclude}] = copy;
+    }
+
+    if (physicsWorld)
+    {
+        // Bodies cannot be shared between worlds, so each one is recreated with its state and fixtures
+        for (auto [ent, collider] : SceneView<Mut<Box2DColliderComponent>>(*fork).each())
+        {
+            const b2Body *source = collider.body;
+            b2BodyDef bodyDef;
+            bodyDef.type = source->GetType();
+            bodyDef.position = source->GetPosition();
+            bodyDef.angle = source->GetAngle();
+            bodyDef.linearVelocity = source->GetLinearVelocity();
+            bodyDef.angularVelocity = source->GetAngularVelocity();
+            bodyDef.linearDamping = source->GetLinearDamping();
+            bodyDef.angularDamping = source->GetAngularDamping();
+            bodyDef.allowSleep = source->IsSleepingAllowed();
+            bodyDef.awake = source->IsAwake();
+            bodyDef.fixedRotation = source->IsFixedRotation();
+            bodyDef.bullet = source->IsBullet();
+            bodyDef.enabled = source->IsEnabled();
+            bodyDef.gravityScale = source->GetGravityScale();
+            bodyDef.userData.pointer = (uintptr_t)ent;
+            collider.body = physicsWorld->CreateBody(&bodyDef);
+
+            for (const b2Fixture *fixture = source->GetFixtureList(); fixture; fixture = fixture->GetNext())
+            {
+                b2FixtureDef fixtureDef;
+                fixtureDef.shape = fixture->GetShape();
+                fixtureDef.density = fixture->GetDensity();
+                fixtureDef.friction = fixture->GetFriction();
+                fixtureDef.restitution = fixture->GetRestitution();
+                fixtureDef.restitutionThreshold = fixture->GetRestitutionThreshold();
+                fixtureDef.isSensor = fixture->IsSensor();
+                fixtureDef.filter = fixture->GetFilterData();
+                collider.body->CreateFixture(&fixtureDef);
+            }
+        }
+    }
+    return fork;
 }
 
-bool Scene::IsEntityValid(EntityID id)
+Scene *Scene::ForkWithPhysics()
 {
-    // Check if the index is our invalid index
-    return (id >> 32) != EntityIndex(-1);
+    // The parent's bodies are read while copying them, so its world must not be stepping
+    b2World *source = ownedWorld ? ownedWorld.get() : physics ? physics->World() : nullptr;
+    if (source == nullptr)
+    {
+        return Fork();
+    }
+
+    b2World *world = new b2World(source->GetGravity());
+    Scene *fork = Fork(world);
+    fork->ownedWorld.reset(world);
+    return fork;
+}
+
+void Scene::StepPhysics(float timeStep, int32 velocityIterations, int32 positionIterations, float pixelsPerMeter)
+{
+    if (!ownedWorld)
+    {
+        return;
+    }
+
+    ownedWorld->Step(timeStep, velocityIterations, positionIterations);
+    for (auto [ent, collider, transform] : SceneView<Box2DColliderComponent, Optional<TransformComponent>>(*this).each())
+    {
+        if (collider.isStatic)
+        {
+            continue;
+        }
+        // Only the bodies that moved are written, so the pages of the others stay shared with the parent
+        b2Vec2 position = collider.body->GetPosition();
+        if (collider.position != position)
+        {
+            GetMut<Box2DColliderComponent>(ent)->position = position;
+        }
+        if (transform && (transform->x != position.x * pixelsPerMeter || transform->y != position.y * pixelsPerMeter))
+        {
+            TransformComponent *moved = GetMut<TransformComponent>(ent);
+            moved->x = position.x * pixelsPerMeter;
+            moved->y = position.y * pixelsPerMeter;
+        }
+    }
+}
+
+void Scene::UnloadLevel(b2World *physicsWorld)
+{
+    if (physicsWorld)
+    {
+        // Bodies live in the world, the scene only holds pointers to them
+        for (auto [ent, collider] : SceneView<Mut<Box2DColliderComponent>>(*this).each())
+        {
+            if (collider.body)
+            {
+                physicsWorld->DestroyBody(collider.body);
+                collider.body = nullptr;
+            }
+        }
+    }
+
+    // Staged components of unflushed commands belong to the level too
+    for (CommandBuffer *buffer : commandBuffers)
+    {
+        buffer->Clear();
+    }
+
+#ifdef ECS_ARCHETYPE_STORAGE
+    for (Archetype *archetype : archetypes)
+    {
+        archetype->Clear();
+    }
+    locations.clear();
+#else
+    for (ComponentPool *pool : componentPools)
+    {
+        pool->clear();
+    }
+    for (OwningGroup *group : groups)
+    {
+        group->size = 0;
+    }
+#endif
+    for (SceneQuery *query : queries)
+    {
+        query->entities.clear();
+        query->positions.clear();
+    }
+
+    entities.clear();
+    freeEntities.clear();
+    hierarchy.Clear();
+    spatialIndex.Clear();
+    mortonKeys.clear();
+    m_selectedEntity = EntityID(-1);
+
+    // Last, so component destructors can still reach level data
+    arena.Reset();
+}
+
+void Scene::MatchEntities(const ComponentMask &include, const ComponentMask &exclude, std::vector<uint64_t> &bitmap)
+{
+    size_t count = entities.size();
+    bitmap.assign((count + 63) / 64, 0);
+    size_t i = 0;
+
+#if defined(__AVX2__) || defined(__SSE2__)
+    // Each entity is an {id, mask} pair of 64 bit words when the mask fits in one word
+    if constexpr (ComponentMask::WORDS == 1 && sizeof(EntityDesc) == 2 * sizeof(uint64_t))
+    {
+        const char *base = reinterpret_cast<const char *>(entities.data());
+
+#if defined(__AVX2__)
+        // Four 256 bit loads test eight entities, ids land in the even lanes and masks in the odd lanes
+        const __m256i includeMask = _mm256_set1_epi64x(static_cast<long long>(include.words[0]));
+        const __m256i excludeMask = _mm256_set1_epi64x(static_cast<long long>(exclude.words[0]));
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i invalidIndex = _mm256_set1_epi64x(EntityIndex(-1));
+        for (; i + 8 <= count; i += 8)
+        {
+            uint64_t bits = 0;
+            for (size_t load = 0; load < 4; load++)
+            {
+                __m256i desc = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(base + (i + 2 * load) * sizeof(EntityDesc)));
+                int match = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(desc, includeMask), includeMask)));
+                match &= _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(desc, excludeMask), zero)));
+                int invalid = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_srli_epi64(desc, 32), invalidIndex)));
+                int valid = (match >> 1) & ~invalid;
+                bits |= uint64_t((valid & 1) | ((valid >> 1) & 2)) << (2 * load);
+            }
+            bitmap[i / 64] |= bits << (i % 64);
+        }
+#else
+        // Two pairs of 128 bit loads test four entities, shuffling ids and masks into their own registers
+        const __m128i includeMask = _mm_set1_epi64x(static_cast<long long>(include.words[0]));
+        const __m128i excludeMask = _mm_set1_epi64x(static_cast<long long>(exclude.words[0]));
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i invalidIndex = _mm_set1_epi32(-1);
+        for (; i + 4 <= count; i += 4)
+        {
+            uint64_t bits = 0;
+            for (size_t pair = 0; pair < 2; pair++)
+            {
+                const char *desc = base + (i + 2 * pair) * sizeof(EntityDesc);
+                __m128 first = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(desc)));
+                __m128 second = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(desc + sizeof(EntityDesc))));
+                __m128i masks = _mm_castps_si128(_mm_shuffle_ps(first, second, _MM_SHUFFLE(3, 2, 3, 2)));
+                __m128i ids = _mm_castps_si128(_mm_shuffle_ps(first, second, _MM_SHUFFLE(1, 0, 1, 0)));
+                int match = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(masks, includeMask), includeMask)));
+                match &= _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(masks, excludeMask), zero)));
+                int invalid = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(ids, invalidIndex)));
+
+                // Both halves of a mask have to match, the index half of each id is in lanes 1 and 3
+                bool firstValid = (match & 0x3) == 0x3 && !(invalid & 0x2);
+                bool secondValid = (match & 0xC) == 0xC && !(invalid & 0x8);
+                bits |= uint64_t(firstValid | (secondValid << 1)) << (2 * pair);
+            }
+            bitmap[i / 64] |= bits << (i % 64);
+        }
+#endif
+    }
+#endif
+
+    // Remaining entities, and masks wider than a single word
+    for (; i < count; i++)
+    {
+        if (IsEntityValid(entities[i].id) && entities[i].mask.contains(include) && !entities[i].mask.intersects(exclude))
+        {
+            bitmap[i / 64] |= uint64_t(1) << (i % 64);
+        }
+    }
+}
+
+SceneQuery *Scene::GetQuery(const ComponentMask &include, const ComponentMask &exclude)
+{
+    std::lock_guard<std::mutex> lock(queryMutex);
+    auto found = queryLookup.find({include, exclude});
+    if (found != queryLookup.end())
+    {
+        return found->second;
+    }
+
+    SceneQuery *query = new SceneQuery(include, exclude);
+#ifdef ECS_ARCHETYPE_STORAGE
+    for (Archetype *archetype : archetypes)
+    {
+        if (query->Matches(archetype->mask))
+        {
+            query->archetypes.push_back(archetype);
+        }
+    }
+#else
+    // Fill the query once from a full mask scan, later changes are applied incrementally
+    std::vector<uint64_t> bitmap;
+    MatchEntities(include, exclude, bitmap);
+    for (size_t word = 0; word < bitmap.size(); word++)
+    {
+        for (uint64_t bits = bitmap[word]; bits; bits &= bits - 1)
+        {
+            query->Add(EntityIndex(word * 64 + __builtin_ctzll(bits)));
+        }
+    }
+#endif
+
+    queries.push_back(query);
+    queryLookup.insert({{include, exclude}, query});
+    return query;
+}
+
+#ifndef ECS_ARCHETYPE_STORAGE
+OwningGroup *Scene::GetGroup(const ComponentMask &owned)
+{
+    std::lock_guard<std::mutex> lock(queryMutex);
+    for (size_t componentId = 0; componentId < COMPONENT_COUNT; componentId++)
+    {
+        if (owned.test(componentId) && poolOwners[componentId])
+        {
+            if (poolOwners[componentId]->owned == owned)
+            {
+                return poolOwners[componentId];
+            }
+            SDL_Log("Component %zu is already owned by another group", componentId);
+            return nullptr;
+        }
+    }
+
+    OwningGroup *group = new OwningGroup();
+    group->owned = owned;
+    for (size_t componentId = 0; componentId < COMPONENT_COUNT; componentId++)
+    {
+        if (owned.test(componentId))
+        {
+            group->pools.push_back(componentPools[componentId]);
+            poolOwners[componentId] = group;
+        }
+    }
+
+    // Pack the entities that already have every owned component
+    std::vector<uint64_t> bitmap;
+    MatchEntities(owned, ComponentMask(), bitmap);
+    for (size_t word = 0; word < bitmap.size(); word++)
+    {
+        for (uint64_t bits = bitmap[word]; bits; bits &= bits - 1)
+        {
+            group->Enter(EntityIndex(word * 64 + __builtin_ctzll(bits)));
+        }
+    }
+
+    groups.push_back(group);
+    return group;
+}
+
+void Scene::LeaveGroups(EntityIndex index, const ComponentMask &removed)
+{
+    for (OwningGroup *group : groups)
+    {
+        if (removed.intersects(group->owned) && entities.at(index).mask.contains(group->owned))
+        {
+            group->Leave(index);
+        }
+    }
+}
+#endif
+
+void Scene::RefreshQueries(EntityIndex index, const ComponentMask &previousMask, bool wasValid)
+{
+#ifndef ECS_ARCHETYPE_STORAGE
+    bool isValid = IsEntityValid(entities.at(index).id);
+
+    // Groups are left before the components are erased, only entering happens here
+    for (OwningGroup *group : groups)
+    {
+        bool had = wasValid && previousMask.contains(group->owned);
+        if (!had && isValid && entities.at(index).mask.contains(group->owned))
+        {
+            group->Enter(index);
+        }
+    }
+
+    for (SceneQuery *query : queries)
+    {
+        bool matched = wasValid && query->Matches(previousMask);
+        bool matches = isValid && query->Matches(entities.at(index).mask);
+        if (matched != matches)
+        {
+            if (matches)
+            {
+                query->Add(index);
+            }
+            else
+            {
+                query->Remove(index);
+            }
+        }
+    }
+#else
+    // Archetype queries track archetypes, which only change when a new one is created
+    std::ignore = index;
+    std::ignore = previousMask;
+    std::ignore = wasValid;
+#endif
 }
 
 EntityID Scene::NewEntity()
 {
+    EntityIndex newIndex;
     if (!freeEntities.empty())
     {
-        EntityIndex newIndex = freeEntities.back();
+        newIndex = freeEntities.back();
         freeEntities.pop_back();
         EntityID newID = CreateEntityId(newIndex, GetEntityVersion(entities.at(newIndex).id));
         entities.at(newIndex).id = newID;
-        return entities.at(newIndex).id;
     }
-    entities.push_back({CreateEntityId(EntityIndex(entities.size()), 0), ComponentMask()});
-    return entities.back().id;
+    else
+    {
+        newIndex = EntityIndex(entities.size());
+        entities.push_back({CreateEntityId(newIndex, 0), ComponentMask()});
+#ifdef ECS_ARCHETYPE_STORAGE
+        locations.emplace_back();
+#endif
+    }
+
+#ifdef ECS_ARCHETYPE_STORAGE
+    // Entities without components live in the root archetype
+    Archetype *root = GetArchetype(ComponentMask());
+    locations.at(newIndex) = {root, root->PushRow(newIndex)};
+#endif
+    RefreshQueries(newIndex, ComponentMask(), false);
+    return entities.at(newIndex).id;
+}
+
+#ifdef ECS_ARCHETYPE_STORAGE
+Archetype *Scene::GetArchetype(const ComponentMask &mask)
+{
+    auto found = archetypeLookup.find(mask);
+    if (found != archetypeLookup.end())
+    {
+        return found->second;
+    }
+
+    Archetype *archetype = new Archetype(mask, componentInfos);
+    archetypes.push_back(archetype);
+    archetypeLookup.insert({mask, archetype});
+
+    // Registered queries only need to learn about new archetypes
+    for (SceneQuery *query : queries)
+    {
+        if (query->Matches(mask))
+        {
+            query->archetypes.push_back(archetype);
+        }
+    }
+    return archetype;
+}
+
+Archetype *Scene::GetArchetypeEdge(Archetype *archetype, int componentId, bool add)
+{
+    std::vector<Archetype *> &edges = add ? archetype->addEdges : archetype->removeEdges;
+    if (edges.size() <= size_t(componentId))
+    {
+        edges.resize(componentId + 1, nullptr);
+    }
+
+    // Cache the neighbour in both directions so the next move is a single lookup
+    if (edges[componentId] == nullptr)
+    {
+        ComponentMask mask = archetype->mask;
+        mask.set(componentId, add);
+        Archetype *neighbour = GetArchetype(mask);
+        edges[componentId] = neighbour;
+
+        std::vector<Archetype *> &backEdges = add ? neighbour->removeEdges : neighbour->addEdges;
+        if (backEdges.size() <= size_t(componentId))
+        {
+            backEdges.resize(componentId + 1, nullptr);
+        }
+        backEdges[componentId] = archetype;
+    }
+    return edges[componentId];
+}
+
+void Scene::MoveEntity(EntityIndex index, Archetype *target)
+{
+    EntityLocation &location = locations.at(index);
+    Archetype *source = location.archetype;
+    size_t targetRow = target->PushRow(index);
+
+    // Relocate every component the target archetype also stores, and destroy the ones it drops
+    for (size_t column = 0; column < source->componentIds.size(); column++)
+    {
+        int targetColumn = target->ColumnOf(source->componentIds[column]);
+        if (targetColumn != -1)
+        {
+            source->columnInfos[column].relocate(target->Get(targetRow, targetColumn), source->Get(location.row, int(column)));
+            target->Ticks(targetRow, targetColumn) = source->Ticks(location.row, int(column));
+        }
+        else if (source->columnInfos[column].destroy)
+        {
+            source->columnInfos[column].destroy(source->Get(location.row, int(column)));
+        }
+    }
+
+    // Fill the hole left in the source archetype
+    EntityIndex moved = source->RemoveRow(location.row);
+    if (moved != EntityIndex(-1))
+    {
+        locations.at(moved).row = location.row;
+    }
+    location = {target, targetRow};
+}
+#endif
+
+void Scene::DestroyEntity(EntityID id)
+{
+    if (entities.at(GetEntityIndex(id)).id != id)
+        return;
+
+    QueueRemoved(GetEntityIndex(id), entities.at(GetEntityIndex(id)).mask);
+
+#ifdef ECS_ARCHETYPE_STORAGE
+    // Destroy the entity's components and release its row in its archetype
+    EntityLocation &location = locations.at(GetEntityIndex(id));
+    location.archetype->DestroyRow(location.row);
+    EntityIndex moved = location.archetype->RemoveRow(location.row);
+    if (moved != EntityIndex(-1))
+    {
+        locations.at(moved).row = location.row;
+    }
+    location = EntityLocation();
+#else
+    // Destroy the entity's component in every pool it has one in
+    LeaveGroups(GetEntityIndex(id), entities.at(GetEntityIndex(id)).mask);
+    for (size_t componentId = 0; componentId < componentPools.size(); componentId++)
+    {
+        if (entities.at(GetEntityIndex(id)).mask.test(componentId))
+        {
+            componentPools[componentId]->erase(GetEntityIndex(id));
+        }
+    }
+#endif
+
+    ComponentMask previousMask = entities.at(GetEntityIndex(id)).mask;
+    EntityID newID = CreateEntityId(EntityIndex(-1), GetEntityVersion(id) + 1);
+    entities.at(GetEntityIndex(id)).id = newID;
+    entities.at(GetEntityIndex(id)).mask.reset();
+    RefreshQueries(GetEntityIndex(id), previousMask, true);
+    freeEntities.push_back(GetEntityIndex(id));
+}
+
+EntityRange Scene::CreateEntities(size_t count, const Prefab &prefab)
+{
+    EntityRange range{EntityIndex(entities.size()), count};
+    entities.reserve(entities.size() + count);
+    for (size_t i = 0; i < count; i++)
+    {
+        entities.push_back({CreateEntityId(range.first + EntityIndex(i), 0), prefab.mask});
+    }
+    ComponentTicks stamp{changeTick, changeTick};
+
+#ifdef ECS_ARCHETYPE_STORAGE
+    // Every entity lands in the same archetype, so the rows are appended and filled column by column
+    Archetype *archetype = GetArchetype(prefab.mask);
+    size_t firstRow = archetype->PushRows(range.first, count, stamp);
+    locations.resize(entities.size());
+    for (size_t i = 0; i < count; i++)
+    {
+        locations[range.first + i] = {archetype, firstRow + i};
+    }
+    for (size_t column = 0; column < archetype->componentIds.size(); column++)
+    {
+        const void *prototype = prefab.values[archetype->componentIds[column]];
+        for (size_t row = firstRow; row < archetype->count;)
+        {
+            size_t run = std::min(archetype->chunkCapacity - row % archetype->chunkCapacity, archetype->count - row);
+            FillComponents(archetype->columnInfos[column], archetype->Get(row, int(column)), run, prototype);
+            row += run;
+        }
+    }
+#else
+    for (size_t componentId = 0; componentId < componentPools.size(); componentId++)
+    {
+        if (prefab.mask.test(componentId))
+        {
+            componentPools[componentId]->appendRange(range.first, count, prefab.values[componentId], stamp);
+        }
+    }
+    for (SceneQuery *query : queries)
+    {
+        if (query->Matches(prefab.mask))
+        {
+            query->AddRange(range.first, count);
+        }
+    }
+    for (OwningGroup *group : groups)
+    {
+        if (prefab.mask.contains(group->owned))
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                group->Enter(range.first + EntityIndex(i));
+            }
+        }
+    }
+#endif
+    return range;
 }
 
-template <typename T>
-T *Scene::Assign(EntityID id)
+void Scene::DestroyEntities(const EntityID *ids, size_t count)
 {
-    if (entities[GetEntityIndex(id)].id != id)
-        return nullptr;
-    size_t componentId = GetId<T>();
+    // Drop stale and repeated ids up front
+    std::vector<uint64_t> marked((entities.size() + 63) / 64, 0);
+    std::vector<EntityIndex> indices;
+    indices.reserve(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        EntityIndex index = GetEntityIndex(ids[i]);
+        if (index >= entities.size() || entities[index].id != ids[i] || ((marked[index / 64] >> (index % 64)) & 1))
+        {
+            continue;
+        }
+        marked[index / 64] |= uint64_t(1) << (index % 64);
+        indices.push_back(index);
+    }
+    for (EntityIndex index : indices)
+    {
+        QueueRemoved(index, entities[index].mask);
+    }
 
-    // Resize the component pool if it doesn't exist yet
-    if (componentPools.size() <= componentId)
+#ifdef ECS_ARCHETYPE_STORAGE
+    for (EntityIndex index : indices)
     {
-        componentPools.resize(componentId + 1, nullptr);
+        EntityLocation &location = locations[index];
+        location.archetype->DestroyRow(location.row);
+        EntityIndex moved = location.archetype->RemoveRow(location.row);
+        if (moved != EntityIndex(-1))
+        {
+            locations[moved].row = location.row;
+        }
+        location = EntityLocation();
     }
-    // If the component pool is null at the index, initialize a new one
-    if (componentPools.at(componentId) == nullptr)
+#else
+    // Group members leave first, so compacting keeps the remaining members packed in front
+    for (EntityIndex index : indices)
     {
-        componentPools.at(componentId) = new ComponentPool(sizeof(T));
+        LeaveGroups(index, entities[index].mask);
     }
 
-    // Looks up the component in the pool, and initializes it with placement new
-    T *pComponent = new (componentPools.at(componentId)->get(GetEntityIndex(id))) T();
+    // Count the destroyed members of each pool and query to pick between erasing and compacting
+    std::array<size_t, COMPONENT_COUNT> poolHits{};
+    std::vector<size_t> queryHits(queries.size(), 0);
+    for (EntityIndex index : indices)
+    {
+        const ComponentMask &mask = entities[index].mask;
+        for (size_t componentId = 0; componentId < COMPONENT_COUNT; componentId++)
+        {
+            poolHits[componentId] += mask.test(componentId);
+        }
+        for (size_t query = 0; query < queries.size(); query++)
+        {
+            queryHits[query] += queries[query]->Matches(mask);
+        }
+    }
 
-    // Set the bit for this component to true and return the created component
-    entities.at(GetEntityIndex(id)).mask.set(componentId);
-    return pComponent;
+    for (size_t componentId = 0; componentId < COMPONENT_COUNT; componentId++)
+    {
+        ComponentPool *pool = componentPools[componentId];
+        if (poolHits[componentId] * 4 > pool->size())
+        {
+            pool->eraseMarked(marked);
+        }
+        else if (poolHits[componentId] > 0)
+        {
+            for (EntityIndex index : indices)
+            {
+                if (entities[index].mask.test(componentId))
+                {
+                    pool->erase(index);
+                }
+            }
+        }
+    }
+    for (size_t query = 0; query < queries.size(); query++)
+    {
+        if (queryHits[query] * 4 > queries[query]->entities.size())
+        {
+            queries[query]->RemoveMarked(marked);
+        }
+        else if (queryHits[query] > 0)
+        {
+            for (EntityIndex index : indices)
+            {
+                if (queries[query]->Matches(entities[index].mask))
+                {
+                    queries[query]->Remove(index);
+                }
+            }
+        }
+    }
+#endif
+
+    freeEntities.reserve(freeEntities.size() + indices.size());
+    for (auto it = indices.rbegin(); it != indices.rend(); ++it)
+    {
+        entities[*it].id = CreateEntityId(EntityIndex(-1), GetEntityVersion(entities[*it].id) + 1);
+        entities[*it].mask.reset();
+        freeEntities.push_back(*it);
+    }
 }
-template TransformComponent *Scene::Assign<TransformComponent>(EntityID id);
-template SpriteComponent *Scene::Assign<SpriteComponent>(EntityID id);
-template InputComponent *Scene::Assign<InputComponent>(EntityID id);
-template SpriteSheetComponent *Scene::Assign<SpriteSheetComponent>(EntityID id);
-template Box2DColliderComponent *Scene::Assign<Box2DColliderComponent>(EntityID id);
-template GridSimulationComponent *Scene::Assign<GridSimulationComponent>(EntityID id);
 
-template <typename T>
-T *Scene::Get(EntityID id)
+void Scene::DestroyEntities(const EntityRange &range)
 {
-    if (entities[GetEntityIndex(id)].id != id)
-        return nullptr;
+    std::vector<EntityID> ids;
+    ids.reserve(range.size());
+    for (EntityID id : range)
+    {
+        ids.push_back(id);
+    }
+    DestroyEntities(ids.data(), ids.size());
+}
 
-    size_t componentId = GetId<T>();
+bool Scene::SetParent(EntityID child, EntityID parent)
+{
+    if (GetEntityIndex(child) >= entities.size() || entities[GetEntityIndex(child)].id != child ||
+        GetEntityIndex(parent) >= entities.size() || entities[GetEntityIndex(parent)].id != parent)
+        return false;
 
-    if (!entities.at(GetEntityIndex(id)).mask.test(componentId))
-        return nullptr;
+    // Refuse to attach an entity below itself
+    for (EntityID ancestor = parent;;)
+    {
+        if (ancestor == child)
+            return false;
+        uint32_t node = hierarchy.NodeOf(GetEntityIndex(ancestor));
+        if (node == TransformHierarchy::NO_NODE)
+            break;
+        ancestor = hierarchy.parents[node];
+    }
 
-    T *pComponent = static_cast<T *>(componentPools.at(componentId)->get(GetEntityIndex(id)));
+    // Assigning can move components, so fetch the transforms once every component exists
+    if (!Get<TransformComponent>(child))
+        Assign<TransformComponent>(child);
+    if (!Get<TransformComponent>(parent))
+        Assign<TransformComponent>(parent);
+    if (!Get<LocalTransformComponent>(child))
+        Assign<LocalTransformComponent>(child);
+    if (!Get<ParentComponent>(child))
+        Assign<ParentComponent>(child);
 
-    // Log the entity id, entity index, and the component id
-    // std::cout << "Entity ID: " << id << " Entity Index: " << GetEntityIndex(id) << " Component ID: " << componentId << std::endl;
-    return pComponent;
+    const TransformComponent *world = Get<TransformComponent>(child);
+    const TransformComponent *parentWorld = Get<TransformComponent>(parent);
+    LocalTransformComponent *local = GetMut<LocalTransformComponent>(child);
+    local->x = world->x - parentWorld->x;
+    local->y = world->y - parentWorld->y;
+    GetMut<ParentComponent>(child)->parent = parent;
+
+    hierarchy.Attach(GetEntityIndex(child), child, parent);
+    return true;
 }
 
-template TransformComponent *Scene::Get<TransformComponent>(EntityID id);
-template SpriteComponent *Scene::Get<SpriteComponent>(EntityID id);
-template InputComponent *Scene::Get<InputComponent>(EntityID id);
-template SpriteSheetComponent *Scene::Get<SpriteSheetComponent>(EntityID id);
-template Box2DColliderComponent *Scene::Get<Box2DColliderComponent>(EntityID id);
-template GridSimulationComponent *Scene::Get<GridSimulationComponent>(EntityID id);
+void Scene::ClearParent(EntityID child)
+{
+    if (GetEntityIndex(child) >= entities.size() || entities[GetEntityIndex(child)].id != child)
+        return;
+    Remove<ParentComponent>(child);
+    Remove<LocalTransformComponent>(child);
+    hierarchy.Detach(GetEntityIndex(child));
+}
+
+void Scene::UpdateHierarchy()
+{
+    constexpr int transformId = ComponentTraits<TransformComponent>::ID;
+    constexpr int localId = ComponentTraits<LocalTransformComponent>::ID;
+    constexpr int parentId = ComponentTraits<ParentComponent>::ID;
+
+    // Drop the nodes invalidated by destroyed entities or removed components since the last pass
+    for (size_t node = hierarchy.entities.size(); node-- > 0;)
+    {
+        EntityID child = hierarchy.entities[node];
+        EntityID parent = hierarchy.parents[node];
+        const EntityDesc &childDesc = entities[GetEntityIndex(child)];
+        const EntityDesc &parentDesc = entities[GetEntityIndex(parent)];
+        bool childAlive = childDesc.id == child;
+        bool childValid = childAlive && childDesc.mask.test(parentId) && childDesc.mask.test(localId) && childDesc.mask.test(transformId);
+        bool parentValid = parentDesc.id == parent && parentDesc.mask.test(transformId);
+        if (childValid && parentValid)
+            continue;
+
+        // A child left without parent keeps its last world position
+        if (childAlive)
+            ClearParent(child);
+        else
+            hierarchy.Detach(GetEntityIndex(child));
+    }
+    hierarchy.Sort();
+
+    // Breadth first, so the dirty flag of a parent node is known before its children are visited
+    Tick since = hierarchy.lastUpdate;
+    hierarchy.dirty.assign(hierarchy.entities.size(), 0);
+    for (size_t node = 0; node < hierarchy.entities.size(); node++)
+    {
+        EntityIndex childIndex = GetEntityIndex(hierarchy.entities[node]);
+        EntityIndex parentIndex = GetEntityIndex(hierarchy.parents[node]);
+        uint32_t parentNode = hierarchy.parentNodes[node];
+
+        bool parentMoved = parentNode != TransformHierarchy::NO_NODE ? hierarchy.dirty[parentNode] != 0 : TicksOf(parentIndex, transformId).changed > since;
+        if (!parentMoved && TicksOf(childIndex, localId).changed <= since)
+            continue;
+
+        const TransformComponent *parentWorld = Get<TransformComponent>(hierarchy.parents[node]);
+        const LocalTransformComponent *local = Get<LocalTransformComponent>(hierarchy.entities[node]);
+        TransformComponent *world = GetMut<TransformComponent>(hierarchy.entities[node]);
+        world->x = parentWorld->x + local->x;
+        world->y = parentWorld->y + local->y;
+        hierarchy.dirty[node] = 1;
+    }
+    hierarchy.lastUpdate = AdvanceTick();
+}
+
+void Scene::UpdateSpatialIndex()
+{
+    constexpr int transformId = ComponentTraits<TransformComponent>::ID;
+    constexpr int boundsId = ComponentTraits<BoundsComponent>::ID;
+
+    // Drop the entries of destroyed entities and of entities without transform
+    for (size_t position = spatialIndex.tracked.size(); position-- > 0;)
+    {
+        EntityIndex index = spatialIndex.tracked[position];
+        const SpatialHash::Entry &entry = spatialIndex.entries[index];
+        const EntityDesc &desc = entities[index];
+        if (desc.id != entry.id || !desc.mask.test(transformId))
+        {
+            spatialIndex.Erase(index);
+        }
+        else if (!desc.mask.test(boundsId) && (entry.maxX != entry.minX || entry.maxY != entry.minY))
+        {
+            // Bounds removed, the entity is a point again
+            spatialIndex.Update(index, entry.id, entry.minX, entry.minY, entry.minX, entry.minY);
+        }
+    }
+
+    Tick since = spatialIndex.lastUpdate;
+    for (auto [ent, transform, bounds] : SceneView<TransformComponent, Optional<BoundsComponent>, Changed<TransformComponent>>(*this, since).each())
+    {
+        spatialIndex.Update(GetEntityIndex(ent), ent, transform.x, transform.y, transform.x + (bounds ? bounds->width : 0.0f), transform.y + (bounds ? bounds->height : 0.0f));
+    }
+    for (auto [ent, transform, bounds] : SceneView<TransformComponent, BoundsComponent, Changed<BoundsComponent>>(*this, since).each())
+    {
+        spatialIndex.Update(GetEntityIndex(ent), ent, transform.x, transform.y, transform.x + bounds.width, transform.y + bounds.height);
+    }
+    spatialIndex.lastUpdate = AdvanceTick();
+}
 
-template <typename T>
-void Scene::Remove(EntityID id)
+void Scene::SpatialSortStep()
 {
-    // ensures you're not accessing an entity that has been deleted
-    if (entities.at(GetEntityIndex(id)).id != GetEntityIndex(id))
+    constexpr int transformId = ComponentTraits<TransformComponent>::ID;
+
+    // Keys are computed for the sorted storage only, so a step costs the size of that storage
+    std::vector<uint32_t> order;
+    auto sortOrder = [this, &order](size_t count, auto keyAt)
+    {
+        mortonKeys.resize(count);
+        bool sorted = true;
+        for (size_t position = 0; position < count; position++)
+        {
+            mortonKeys[position] = keyAt(position);
+            sorted = sorted && (position == 0 || mortonKeys[position - 1] <= mortonKeys[position]);
+        }
+        if (sorted)
+            return false;
+        order.resize(count);
+        for (uint32_t position = 0; position < count; position++)
+        {
+            order[position] = position;
+        }
+        std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b)
+                         { return mortonKeys[a] < mortonKeys[b]; });
+        return true;
+    };
+
+#ifdef ECS_ARCHETYPE_STORAGE
+    if (archetypes.empty())
+        return;
+    Archetype *archetype = archetypes[spatialSortCursor++ % archetypes.size()];
+    int column = archetype->ColumnOf(transformId);
+    if (column < 0)
+        return;
+    auto keyAt = [this, archetype, column](size_t row)
+    {
+        const TransformComponent *transform = static_cast<const TransformComponent *>(archetype->Get(row, column));
+        return MortonCode(transform->x, transform->y, spatialIndex.cellSize);
+    };
+    if (!sortOrder(archetype->count, keyAt))
         return;
+    archetype->PermuteRows(order);
+    for (size_t row = 0; row < archetype->count; row++)
+    {
+        locations[archetype->EntityAt(row)].row = row;
+    }
+#else
+    // Entities without transform get the largest key and stay behind the others
+    ComponentPool *transforms = componentPools[transformId];
+    auto keyOf = [this, transforms](EntityIndex index)
+    {
+        if (!transforms->contains(index))
+            return uint32_t(UINT32_MAX);
+        const TransformComponent *transform = static_cast<const TransformComponent *>(transforms->read(index));
+        return MortonCode(transform->x, transform->y, spatialIndex.cellSize);
+    };
 
-    int componentId = GetId<T>();
-    entities.at(GetEntityIndex(id)).mask.reset(componentId);
+    size_t storage = spatialSortCursor++ % (componentPools.size() + queries.size());
+    if (storage < componentPools.size())
+    {
+        ComponentPool *pool = componentPools[storage];
+        auto keyAt = [pool, &keyOf](size_t denseIndex)
+        { return keyOf(pool->dense[denseIndex]); };
+        OwningGroup *group = poolOwners[storage];
+        if (group)
+        {
+            // Owned pools must keep the order of their group, so its members are sorted in every pool at once
+            if (group->pools[0] != pool || !sortOrder(group->size, keyAt))
+                return;
+            for (ComponentPool *owned : group->pools)
+            {
+                std::vector<uint32_t> ownedOrder(order);
+                for (size_t denseIndex = group->size; denseIndex < owned->size(); denseIndex++)
+                {
+                    ownedOrder.push_back(uint32_t(denseIndex));
+                }
+                owned->permute(ownedOrder);
+            }
+            return;
+        }
+        if (!sortOrder(pool->size(), keyAt))
+            return;
+        pool->permute(order);
+    }
+    else
+    {
+        SceneQuery *query = queries[storage - componentPools.size()];
+        if (!sortOrder(query->entities.size(), [query, &keyOf](size_t position)
+                       { return keyOf(query->entities[position]); }))
+            return;
+        PermuteValues(query->entities, order);
+        for (size_t position = 0; position < query->entities.size(); position++)
+        {
+            query->positions[query->entities[position]] = EntityIndex(position);
+        }
+    }
+#endif
 }
 
-template void Scene::Remove<TransformComponent>(EntityID id);
-template void Scene::Remove<SpriteComponent>(EntityID id);
-template void Scene::Remove<InputComponent>(EntityID id);
-template void Scene::Remove<SpriteSheetComponent>(EntityID id);
-template void Scene::Remove<Box2DColliderComponent>(EntityID id);
-template void Scene::Remove<GridSimulationComponent>(EntityID id);
+CommandBuffer &Scene::GetCommandBuffer()
+{
+    std::lock_guard<std::mutex> lock(commandMutex);
+    CommandBuffer *&buffer = threadCommandBuffers[std::this_thread::get_id()];
+    if (buffer == nullptr)
+    {
+        buffer = new CommandBuffer();
+        commandBuffers.push_back(buffer);
+    }
+    return *buffer;
+}
 
-void Scene::DestroyEntity(EntityID id)
+void Scene::FlushCommands()
 {
-    EntityID newID = CreateEntityId(EntityIndex(-1), GetEntityVersion(id) + 1);
-    entities.at(GetEntityIndex(id)).id = newID;
-    entities.at(GetEntityIndex(id)).mask.reset();
-    freeEntities.push_back(GetEntityIndex(id));
+    std::unique_lock<std::mutex> lock(commandMutex);
+
+    // Spawn every pending entity first so later commands can refer to them
+    size_t spawnCount = 0;
+    for (CommandBuffer *buffer : commandBuffers)
+    {
+        spawnCount += buffer->pendingCount;
+    }
+    entities.reserve(entities.size() + spawnCount);
+
+    struct PendingCommand
+    {
+        EntityID entity;
+        Command *command;
+    };
+    std::vector<PendingCommand> batch;
+    std::vector<EntityID> spawned;
+    for (CommandBuffer *buffer : commandBuffers)
+    {
+        spawned.assign(buffer->pendingCount, EntityID(-1));
+        for (Command &command : buffer->commands)
+        {
+            if (command.type == CommandType::SPAWN)
+            {
+                spawned[GetEntityVersion(command.entity)] = NewEntity();
+                continue;
+            }
+            EntityID entity = CommandBuffer::IsPending(command.entity) ? spawned.at(GetEntityVersion(command.entity)) : command.entity;
+            batch.push_back({entity, &command});
+        }
+    }
+
+    // Group the commands by entity, keeping the recording order inside a group
+    std::stable_sort(batch.begin(), batch.end(), [this](const PendingCommand &a, const PendingCommand &b)
+                     { return GetEntityIndex(a.entity) < GetEntityIndex(b.entity); });
+
+    for (size_t begin = 0, end = 0; begin < batch.size(); begin = end)
+    {
+        EntityIndex index = GetEntityIndex(batch[begin].entity);
+        end = begin + 1;
+        while (end < batch.size() && GetEntityIndex(batch[end].entity) == index)
+        {
+            end++;
+        }
+
+        // Commands on entities that no longer exist are dropped, their payloads are destroyed on clear
+        if (index >= entities.size())
+        {
+            continue;
+        }
+        EntityID liveId = entities[index].id;
+
+        // Merge the group into the final set of assigned and removed components
+        Command *assigns[COMPONENT_COUNT]{};
+        ComponentMask assigned;
+        ComponentMask removed;
+        bool destroy = false;
+        for (size_t i = begin; i < end && !destroy; i++)
+        {
+            Command &command = *batch[i].command;
+            if (batch[i].entity != liveId)
+            {
+                continue;
+            }
+            switch (command.type)
+            {
+            case CommandType::ASSIGN:
+                assigns[command.componentId] = &command;
+                assigned.set(command.componentId);
+                removed.reset(command.componentId);
+                break;
+            case CommandType::REMOVE:
+                assigns[command.componentId] = nullptr;
+                assigned.reset(command.componentId);
+                removed.set(command.componentId);
+                break;
+            case CommandType::DESTROY:
+                destroy = true;
+                break;
+            default:
+                break;
+            }
+        }
+
+        if (destroy)
+        {
+            DestroyEntity(liveId);
+        }
+        else if (!assigned.none() || !removed.none())
+        {
+            ApplyComponentCommands(index, assigned, removed, assigns);
+        }
+    }
+
+    for (CommandBuffer *buffer : commandBuffers)
+    {
+        buffer->Clear();
+    }
+
+    // Handlers may record commands, so the buffers are released first
+    lock.unlock();
+    DispatchObservers();
+}
+
+void Scene::DispatchObservers()
+{
+    // Changes made by the handlers get a later tick and go to the next batch
+    Tick closing = AdvanceTick();
+    for (ComponentObserverBase *observer : observers)
+    {
+        if (observer)
+        {
+            observer->Dispatch(*this, closing);
+        }
+    }
+}
+
+void Scene::CollectTicked(int componentId, Tick since, bool added, std::vector<EntityID> &result)
+{
+    auto accept = [since, added](const ComponentTicks &ticks)
+    { return added ? ticks.added > since : ticks.changed > since && ticks.added <= since; };
+#ifdef ECS_ARCHETYPE_STORAGE
+    for (Archetype *archetype : archetypes)
+    {
+        int column = archetype->ColumnOf(componentId);
+        if (column == -1)
+        {
+            continue;
+        }
+        for (size_t row = 0; row < archetype->count; row++)
+        {
+            if (accept(archetype->columnTicks[column][row]))
+            {
+                result.push_back(entities[archetype->EntityAt(row)].id);
+            }
+        }
+    }
+#else
+    const ComponentPool *pool = componentPools[componentId];
+    for (size_t position = 0; position < pool->size(); position++)
+    {
+        if (accept(pool->ticks[position]))
+        {
+            result.push_back(entities[pool->dense[position]].id);
+        }
+    }
+#endif
+}
+
+void Scene::ApplyComponentCommands(EntityIndex index, const ComponentMask &assigned, const ComponentMask &removed, Command *const *assigns)
+{
+    ComponentMask previousMask = entities.at(index).mask;
+    ComponentMask mask = previousMask | assigned;
+    for (size_t componentId = 0; componentId < COMPONENT_COUNT; componentId++)
+    {
+        if (removed.test(componentId))
+        {
+            mask.reset(componentId);
+        }
+    }
+    QueueRemoved(index, removed & previousMask);
+
+#ifdef ECS_ARCHETYPE_STORAGE
+    // A single move to the final archetype, dropped components are destroyed on the way
+    if (mask != previousMask)
+    {
+        MoveEntity(index, GetArchetype(mask));
+    }
+#else
+    LeaveGroups(index, removed & previousMask);
+    for (size_t componentId = 0; componentId < COMPONENT_COUNT; componentId++)
+    {
+        if (removed.test(componentId) && previousMask.test(componentId))
+        {
+            componentPools[componentId]->erase(index);
+        }
+    }
+#endif
+
+    // Move the staged components into their storage, replacing existing ones
+    for (size_t componentId = 0; componentId < COMPONENT_COUNT; componentId++)
+    {
+        if (!assigned.test(componentId))
+        {
+            continue;
+        }
+        const ComponentInfo &info = RegisteredComponents()[componentId];
+#ifdef ECS_ARCHETYPE_STORAGE
+        const EntityLocation &location = locations.at(index);
+        void *pMemory = location.archetype->Get(location.row, location.archetype->ColumnOf(int(componentId)));
+#else
+        void *pMemory = componentPools[componentId]->emplace(index);
+#endif
+        if (previousMask.test(componentId) && info.destroy)
+        {
+            info.destroy(pMemory);
+        }
+        info.relocate(pMemory, assigns[componentId]->payload);
+        assigns[componentId]->payload = nullptr;
+        TicksOf(index, int(componentId)) = {changeTick, changeTick};
+    }
+
+    entities.at(index).mask = mask;
+    if (mask != previousMask)
+    {
+        RefreshQueries(index, previousMask, true);
+    }
 }
 
 void Scene::CreateSpriteSheetTile(int x, int y, b2World *physicsWorld, Board *board)
@@ -136,46 +1252,94 @@ void Scene::CreateSpriteSheetTile(int x, int y, b2World *physicsWorld, Board *bo
     TransformComponent *trans = Assign<TransformComponent>(entity);
     trans->x = x * board->m_boardWidth;
     trans->y = y * board->m_boardHeight;
-    trans->hasParent = true;
+    Assign<ChildTag>(entity);
 
     AddBox2DCollider(entity, true, false, x, y, 1, 1, physicsWorld);
 }
 
-void Scene::AddBox2DCollider(EntityID entityID, bool isStatic, bool isTrigger, float x, float y, float width, float height, b2World *physicsWorld)
+EntityRange Scene::CreateSpriteSheetTiles(const std::vector<int> &tiles, b2World *physicsWorld, Board *board)
 {
-    Box2DColliderComponent *box2dCollider = Assign<Box2DColliderComponent>(entityID);
+    size_t tileCount = tiles.size() - std::count(tiles.begin(), tiles.end(), -1);
 
-    box2dCollider->bodyDef.position.Set(x, y);
+    Prefab tile;
+    tile.Assign<TransformComponent>();
+    tile.Assign<ChildTag>();
+    tile.Assign<Box2DColliderComponent>();
+    tile.Assign<Box2DBodyDescComponent>()->SetBox(true, 0, 0, 1, 1);
+    EntityRange range = CreateEntities(tileCount, tile);
 
-    if (isStatic)
+    // Only the position and the physics body differ between tiles
+    size_t next = 0;
+    for (size_t i = 0; i < tiles.size(); i++)
     {
-        box2dCollider->bodyDef.type = b2_staticBody; // Static body does not move
+        if (tiles[i] == -1)
+        {
+            continue;
+        }
+        int x = i % board->m_boardWidth;
+        int y = i / board->m_boardWidth;
+        EntityID entity = range[next++];
+        TransformComponent *trans = GetMut<TransformComponent>(entity);
+        trans->x = x * board->m_boardWidth;
+        trans->y = y * board->m_boardHeight;
+        GetMut<Box2DBodyDescComponent>(entity)->bodyDef.position.Set(x, y);
     }
-    else
+    CreateBox2DBodies(physicsWorld);
+    return range;
+}
+
+void Scene::AddBox2DCollider(EntityID entityID, bool isStatic, bool isTrigger, float x, float y, float width, float height, b2World *physicsWorld)
+{
+    // Assign every component before filling the description, assigning may move it with archetype storage
+    Assign<Box2DColliderComponent>(entityID);
+    if (isTrigger)
     {
-        box2dCollider->bodyDef.type = b2_dynamicBody; // Dynamic body can move and collide with others
+        Assign<TriggerTag>(entityID);
+        Assign<CollisionCallbackComponent>(entityID)->onCollisionEnter = []()
+        {
+            SDL_Log("Trigger entered");
+        };
     }
+    Box2DBodyDescComponent *desc = Assign<Box2DBodyDescComponent>(entityID);
+    desc->SetBox(isStatic, x, y, width, height);
+    desc->fixtureDef.isSensor = isTrigger;
 
-    box2dCollider->body = physicsWorld->CreateBody(&box2dCollider->bodyDef);
+    CreateBox2DBody(entityID, physicsWorld);
+}
 
-    box2dCollider->shape.SetAsBox(width / 2, height / 2); // Set box shape (half-width, half-height)
+void Scene::CreateBox2DBody(EntityID entityID, b2World *physicsWorld)
+{
+    Box2DColliderComponent *box2dCollider = GetMut<Box2DColliderComponent>(entityID);
+    Box2DBodyDescComponent *desc = GetMut<Box2DBodyDescComponent>(entityID);
 
-    box2dCollider->fixtureDef.shape = &box2dCollider->shape;
-    box2dCollider->fixtureDef.density = 1.0f;  // Set density for dynamic behavior
-    box2dCollider->fixtureDef.friction = 0.2f; // Set friction
+    desc->bodyDef.userData.pointer = (uintptr_t)entityID;
+    box2dCollider->body = physicsWorld->CreateBody(&desc->bodyDef);
 
-    b2BodyUserData data = box2dCollider->body->GetUserData();
-    data.pointer = (uintptr_t)entityID;
+    desc->fixtureDef.shape = &desc->shape;
+    box2dCollider->body->CreateFixture(&desc->fixtureDef);
 
-    box2dCollider->body->CreateFixture(&box2dCollider->fixtureDef);
+    // Keep what the per frame loops need, the description is no longer used
+    box2dCollider->position = desc->bodyDef.position;
+    box2dCollider->halfExtents.SetZero();
+    for (int i = 0; i < desc->shape.m_count; i++)
+    {
+        box2dCollider->halfExtents = b2Max(box2dCollider->halfExtents, b2Abs(desc->shape.m_vertices[i]));
+    }
+    box2dCollider->isStatic = desc->bodyDef.type == b2_staticBody;
+    box2dCollider->isTrigger = desc->fixtureDef.isSensor;
+    Remove<Box2DBodyDescComponent>(entityID);
+}
 
-    if (isTrigger)
+void Scene::CreateBox2DBodies(b2World *physicsWorld)
+{
+    // Removing the descriptions changes the view, so collect the entities first
+    std::vector<EntityID> pending;
+    for (auto [ent, box2dCollider, desc] : SceneView<Box2DColliderComponent, Box2DBodyDescComponent>(*this).each())
     {
-        box2dCollider->isTrigger = true;
-        box2dCollider->fixtureDef.isSensor = true;
-        box2dCollider->onCollisionEnter = []()
-        {
-            SDL_Log("Trigger entered");
-        };
+        pending.push_back(ent);
     }
-}
\ No newline at end of file
+    for (EntityID ent : pending)
+    {
+        CreateBox2DBody(ent, physicsWorld);
+    }
+}
@@ -106,9 +106,9 @@ void SpriteSheet::AddTileId(int id, int xpos, int ypos)
     }
 }
 
-void SpriteSheet::Render(SDLLayer *const sdlLayer) const
+void SpriteSheet::Extract(RenderPacket &packet) const
 {
-    // For each tile in the m_board draw a texture component at its position
+    // For each tile in the m_board add a sample of the tile set at its position
     for (int row = 0; row < m_board->m_boardHeight; row++)
     {
         for (int col = 0; col < m_board->m_boardWidth; col++)
@@ -121,7 +121,12 @@ void SpriteSheet::Render(SDLLayer *const sdlLayer) const
                 int tile_x = tile_id % m_tilesetCols;
                 int tile_y = tile_id / m_tilesetCols;
 
-                sdlLayer->DrawTextureSample(m_tilesetTexture, col * m_board->m_tileSize, row * m_board->m_tileSize, m_board->m_tileSize, m_board->m_tileSize, tile_x * m_tileSize, tile_y * m_tileSize, m_tileSize, m_tileSize);
+                DrawCommand command;
+                command.texture = m_tilesetTexture;
+                command.src = {float(tile_x * m_tileSize), float(tile_y * m_tileSize), float(m_tileSize), float(m_tileSize)};
+                command.dst = {float(col * m_board->m_tileSize), float(row * m_board->m_tileSize), float(m_board->m_tileSize), float(m_board->m_tileSize)};
+                command.layer = SPRITESHEET_LAYER;
+                packet.commands.push_back(command);
             }
         }
     }
@@ -0,0 +1,178 @@
+#include "SystemScheduler.hpp"
+#include <algorithm>
+#include <numeric>
+
+SystemScheduler::SystemHandle SystemScheduler::Add(SystemDesc system)
+{
+    m_systems.push_back(std::move(system));
+    m_dirty = true;
+    return m_systems.size() - 1;
+}
+
+void SystemScheduler::After(SystemHandle before, SystemHandle after)
+{
+    m_constraints.push_back({before, after});
+    m_dirty = true;
+}
+
+void SystemScheduler::Build()
+{
+    size_t count = m_systems.size();
+    m_dependents.assign(count, {});
+    m_dependencyCounts.assign(count, 0);
+    auto addEdge = [this](size_t before, size_t after)
+    {
+        std::vector<size_t> &dependents = m_dependents[before];
+        if (std::find(dependents.begin(), dependents.end(), after) == dependents.end())
+        {
+            dependents.push_back(after);
+            m_dependencyCounts[after]++;
+        }
+    };
+
+    // Conflicts keep the registration order, so these edges alone never form a cycle
+    for (size_t later = 0; later < count; later++)
+    {
+        const SystemDesc &b = m_systems[later];
+        for (size_t earlier = 0; earlier < later; earlier++)
+        {
+            const SystemDesc &a = m_systems[earlier];
+            bool conflict = a.exclusive || b.exclusive ||
+                            a.writes.intersects(b.reads | b.writes) || b.writes.intersects(a.reads);
+            if (conflict)
+            {
+                addEdge(earlier, later);
+            }
+        }
+    }
+    for (const std::pair<SystemHandle, SystemHandle> &constraint : m_constraints)
+    {
+        addEdge(constraint.first, constraint.second);
+    }
+
+    // Kahn's algorithm, an explicit constraint against the registration order may close a cycle
+    m_order.clear();
+    std::vector<size_t> counts = m_dependencyCounts;
+    for (size_t system = 0; system < count; system++)
+    {
+        if (counts[system] == 0)
+        {
+            m_order.push_back(system);
+        }
+    }
+    for (size_t i = 0; i < m_order.size(); i++)
+    {
+        for (size_t dependent : m_dependents[m_order[i]])
+        {
+            if (--counts[dependent] == 0)
+            {
+                m_order.push_back(dependent);
+            }
+        }
+    }
+    if (m_order.size() != count)
+    {
+        SDL_Log("System ordering constraints form a cycle, running the systems in registration order");
+        for (size_t system = 0; system < count; system++)
+        {
+            m_dependents[system].clear();
+            m_dependencyCounts[system] = system == 0 ? 0 : 1;
+            if (system + 1 < count)
+            {
+                m_dependents[system].push_back(system + 1);
+            }
+        }
+        m_order.resize(count);
+        std::iota(m_order.begin(), m_order.end(), 0);
+    }
+
+    m_remaining.reset(new std::atomic<size_t>[count]);
+    m_dirty = false;
+}
+
+void SystemScheduler::Run(bool serial)
+{
+    Start(serial);
+    Finish();
+}
+
+void SystemScheduler::Start(bool serial)
+{
+    if (m_dirty)
+    {
+        Build();
+    }
+    if (serial)
+    {
+        for (size_t system : m_order)
+        {
+            m_systems[system].run();
+        }
+        return;
+    }
+
+    for (size_t system = 0; system < m_systems.size(); system++)
+    {
+        m_remaining[system] = m_dependencyCounts[system];
+    }
+    for (size_t system = 0; system < m_systems.size(); system++)
+    {
+        if (m_dependencyCounts[system] == 0)
+        {
+            Release(system, m_counter);
+        }
+    }
+}
+
+void SystemScheduler::Finish()
+{
+    // The calling thread runs the main thread systems as they become ready and helps with the rest
+    while (m_counter.pending.load() != 0)
+    {
+        size_t system = size_t(-1);
+        {
+            std::lock_guard<std::mutex> lock(m_mainMutex);
+            if (!m_mainReady.empty())
+            {
+                system = m_mainReady.back();
+                m_mainReady.pop_back();
+            }
+        }
+        if (system != size_t(-1))
+        {
+            Execute(system, m_counter);
+            m_counter.pending--;
+        }
+        else if (!m_jobs->RunPending())
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void SystemScheduler::Release(size_t system, JobCounter &counter)
+{
+    if (m_systems[system].mainThread)
+    {
+        // Counted until Run has executed it
+        counter.pending++;
+        std::lock_guard<std::mutex> lock(m_mainMutex);
+        m_mainReady.push_back(system);
+        return;
+    }
+    m_jobs->Submit([this, system, &counter]
+                   { Execute(system, counter); },
+                   counter);
+}
+
+void SystemScheduler::Execute(size_t system, JobCounter &counter)
+{
+    m_systems[system].run();
+    for (size_t dependent : m_dependents[system])
+    {
+        if (--m_remaining[dependent] == 0)
+        {
+            Release(dependent, counter);
+        }
+    }
+}
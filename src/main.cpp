@@ -1,6 +1,7 @@
 #include "Application.hpp"
 #include <pybind11/pybind11.h>
 #include <pybind11/functional.h>
+#include <pybind11/stl.h>
 
 namespace py = pybind11;
 
@@ -24,6 +25,7 @@ PYBIND11_MODULE(blockbyte, m)
         .def(py::init<Board *, bool>())
         .def("Loop", &Application::Loop)
         .def("ImportSpritesheetLevel", &Application::ImportSpritesheetLevel)
+        .def("UnloadLevel", &Application::UnloadLevel)
         .def("AddBox2D", &Application::AddBox2D)
         .def("AddSprite", &Application::AddSprite)
         .def("GetScene", &Application::GetScene, py::return_value_policy::reference)
@@ -36,41 +38,118 @@ PYBIND11_MODULE(blockbyte, m)
         .def(py::init<>())
         .def("NewEntity", &Scene::NewEntity)
         .def("AddBox2DCollider", &Scene::AddBox2DCollider)
-
-        // Assign Components
+        .def("DestroyEntity", &Scene::DestroyEntity)
+        .def("GetCommandBuffer", &Scene::GetCommandBuffer, py::return_value_policy::reference)
+        // The fork gets a world of its own with copies of the bodies, stepped with StepPhysics
+        .def("Fork", &Scene::ForkWithPhysics, py::return_value_policy::take_ownership)
+        .def("StepPhysics", &Scene::StepPhysics)
+        .def_readwrite("m_spatialSort", &Scene::m_spatialSort)
+        .def("SetParent", &Scene::SetParent)
+        .def("ClearParent", &Scene::ClearParent)
+
+        // Spatial queries, answered from the index as of the end of the last frame
+        .def("QueryAABB", [](Scene &scene, float minX, float minY, float maxX, float maxY)
+             { std::vector<EntityID> result; scene.spatialIndex.QueryAABB(minX, minY, maxX, maxY, result); return result; })
+        .def("QueryRadius", [](Scene &scene, float x, float y, float radius)
+             { std::vector<EntityID> result; scene.spatialIndex.QueryRadius(x, y, radius, result); return result; })
+        .def("QueryNearest", [](Scene &scene, float x, float y, size_t k)
+             { std::vector<EntityID> result; scene.spatialIndex.QueryNearest(x, y, k, result); return result; })
+        .def("Pick", [](Scene &scene, float x, float y)
+             { return scene.spatialIndex.Pick(x, y); })
+
+        // Assign Components, Get returns a copy to read without marking the component changed or copying
+        // a page shared with a fork, GetMut returns the component itself for writing
         .def("AssignTransformComponent", &Scene::Assign<TransformComponent>)
-        .def("GetTransformComponent", &Scene::Get<TransformComponent>, py::return_value_policy::reference)
+        .def("GetTransformComponent", &Scene::Get<TransformComponent>, py::return_value_policy::copy)
+        .def("GetMutTransformComponent", &Scene::GetMut<TransformComponent>, py::return_value_policy::reference)
+        .def("GetLocalTransformComponent", &Scene::Get<LocalTransformComponent>, py::return_value_policy::copy)
+        .def("GetMutLocalTransformComponent", &Scene::GetMut<LocalTransformComponent>, py::return_value_policy::reference)
+
+        .def("AssignBoundsComponent", &Scene::Assign<BoundsComponent>, py::return_value_policy::reference)
+        .def("GetBoundsComponent", &Scene::Get<BoundsComponent>, py::return_value_policy::copy)
+        .def("GetMutBoundsComponent", &Scene::GetMut<BoundsComponent>, py::return_value_policy::reference)
 
-        .def("AssignSpriteComponent", &Scene::Assign<SpriteComponent>)
-        .def("GetSpriteComponent", &Scene::Get<SpriteComponent>, py::return_value_policy::reference)
+        // Sprites are shared between entities with equal values and read only once assigned
+        .def("AssignSpriteComponent", &Scene::AssignShared<SpriteComponent>, py::return_value_policy::reference)
+        .def("GetSpriteComponent", &Scene::GetShared<SpriteComponent>, py::return_value_policy::reference)
+        .def("ShareSpriteComponent", &Scene::Share<SpriteComponent>)
 
         .def("AssignInputComponent", &Scene::Assign<InputComponent>)
-        .def("GetInputComponent", &Scene::Get<InputComponent>, py::return_value_policy::reference)
+        .def("GetInputComponent", &Scene::Get<InputComponent>, py::return_value_policy::copy)
+        .def("GetMutInputComponent", &Scene::GetMut<InputComponent>, py::return_value_policy::reference)
 
+        // Components without writable fields are returned by reference
         .def("AssignSpriteSheetComponent", &Scene::Assign<SpriteSheetComponent>)
         .def("GetSpriteSheetComponent", &Scene::Get<SpriteSheetComponent>, py::return_value_policy::reference)
 
         .def("AssignBox2DColliderComponent", &Scene::Assign<Box2DColliderComponent>)
         .def("GetBox2DColliderComponent", &Scene::Get<Box2DColliderComponent>, py::return_value_policy::reference)
 
+        .def("AssignCollisionCallbackComponent", &Scene::Assign<CollisionCallbackComponent>, py::return_value_policy::reference)
+        .def("GetCollisionCallbackComponent", &Scene::Get<CollisionCallbackComponent>, py::return_value_policy::copy)
+        .def("GetMutCollisionCallbackComponent", &Scene::GetMut<CollisionCallbackComponent>, py::return_value_policy::reference)
+
         .def("AssignGridSimulationComponent", &Scene::Assign<GridSimulationComponent>)
         .def("GetGridSimulationComponent", &Scene::Get<GridSimulationComponent>, py::return_value_policy::reference);
 
+    // Deferred structural changes, safe to record from collision callbacks
+    py::class_<CommandBuffer>(m, "CommandBuffer")
+        .def("Spawn", &CommandBuffer::Spawn)
+        .def("Destroy", &CommandBuffer::Destroy)
+        .def("AssignTransformComponent", [](CommandBuffer &buffer, EntityID id, const TransformComponent &transform)
+             { *buffer.Assign<TransformComponent>(id) = transform; })
+        .def("AssignSpriteComponent", [](CommandBuffer &buffer, EntityID id, const Shared<SpriteComponent> &sprite)
+             { *buffer.Assign<Shared<SpriteComponent>>(id) = sprite; })
+        .def("AssignInputComponent", [](CommandBuffer &buffer, EntityID id, const InputComponent &input)
+             { *buffer.Assign<InputComponent>(id) = input; })
+        .def("RemoveTransformComponent", &CommandBuffer::Remove<TransformComponent>)
+        .def("RemoveSpriteComponent", &CommandBuffer::Remove<Shared<SpriteComponent>>)
+        .def("RemoveInputComponent", &CommandBuffer::Remove<InputComponent>)
+        .def("RemoveBox2DColliderComponent", &CommandBuffer::Remove<Box2DColliderComponent>);
+
     // Define component classes
     py::class_<TransformComponent>(m, "TransformComponent")
         .def(py::init<>())
         .def_readwrite("x", &TransformComponent::x)
         .def_readwrite("y", &TransformComponent::y);
 
+    py::class_<BoundsComponent>(m, "BoundsComponent")
+        .def(py::init<>())
+        .def_readwrite("width", &BoundsComponent::width)
+        .def_readwrite("height", &BoundsComponent::height);
+
+    py::class_<LocalTransformComponent>(m, "LocalTransformComponent")
+        .def(py::init<>())
+        .def_readwrite("x", &LocalTransformComponent::x)
+        .def_readwrite("y", &LocalTransformComponent::y);
+
+    // Read only, GetSpriteComponent returns the value shared by every entity using it
     py::class_<SpriteComponent>(m, "SpriteComponent")
         .def(py::init<>())
-        .def_readwrite("filePath", &SpriteComponent::filePath)
-        .def_readwrite("width", &SpriteComponent::width)
-        .def_readwrite("height", &SpriteComponent::height);
+        .def(py::init([](const std::string &filePath, float width, float height)
+                      { return SpriteComponent{filePath, width, height, nullptr}; }),
+             py::arg("filePath"), py::arg("width"), py::arg("height"))
+        .def_readonly("filePath", &SpriteComponent::filePath)
+        .def_readonly("width", &SpriteComponent::width)
+        .def_readonly("height", &SpriteComponent::height);
+
+    // Handle to a sprite value stored once per scene, from Scene.ShareSpriteComponent
+    py::class_<Shared<SpriteComponent>>(m, "SharedSpriteComponent")
+        .def("Get", &Shared<SpriteComponent>::get, py::return_value_policy::reference)
+        .def("UseCount", &Shared<SpriteComponent>::UseCount);
 
     py::class_<Box2DColliderComponent>(m, "Box2DColliderComponent")
         .def(py::init<>())
-        .def_readwrite("onCollisionEnter", &Box2DColliderComponent::onCollisionEnter);
+        .def_property_readonly("x", [](const Box2DColliderComponent &collider)
+                               { return collider.position.x; })
+        .def_property_readonly("y", [](const Box2DColliderComponent &collider)
+                               { return collider.position.y; })
+        .def_readonly("isStatic", &Box2DColliderComponent::isStatic)
+        .def_readonly("isTrigger", &Box2DColliderComponent::isTrigger);
+
+    py::class_<CollisionCallbackComponent>(m, "CollisionCallbackComponent")
+        .def(py::init<>())
+        .def_readwrite("onCollisionEnter", &CollisionCallbackComponent::onCollisionEnter);
 
     py::class_<InputComponent>(m, "InputComponent")
         .def(py::init<>())
@@ -0,0 +1,75 @@
+#include "InputQueue.hpp"
+#include "Test.hpp"
+#include <thread>
+
+int main()
+{
+    // Elements come out in order, and a full ring rejects pushes until an element is popped
+    SpscRing<uint32_t, 8> ring;
+    uint32_t value = 0;
+    CHECK(!ring.Pop(value));
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        CHECK(ring.Push(i));
+    }
+    CHECK(ring.Full() && !ring.Push(8));
+    CHECK(ring.Pop(value) && value == 0);
+    CHECK(!ring.Full() && ring.Push(8));
+    for (uint32_t i = 1; i <= 8; i++)
+    {
+        CHECK(ring.Pop(value) && value == i);
+    }
+    CHECK(!ring.Pop(value));
+
+    // With a producer and a consumer thread every element arrives once and in order, across wrap arounds
+    SpscRing<uint64_t, 64> shared;
+    const uint64_t count = 200000;
+    std::thread producer([&shared, count]
+                         {
+        for (uint64_t i = 1; i <= count; i++)
+        {
+            while (!shared.Push(i))
+            {
+                std::this_thread::yield();
+            }
+        } });
+    uint64_t expected = 1;
+    uint64_t received = 0;
+    while (expected <= count)
+    {
+        if (shared.Pop(received))
+        {
+            CHECK(received == expected);
+            expected++;
+        }
+    }
+    producer.join();
+    CHECK(!shared.Pop(received));
+
+    // A frame of events folds into held, pressed and changed actions
+    ActionState actions;
+    actions.BeginFrame();
+    actions.Apply({1, SDLK_a, InputEventKind::KEY_DOWN});
+    actions.Apply({2, SDLK_a, InputEventKind::KEY_UP});
+    actions.Apply({3, SDLK_d, InputEventKind::KEY_DOWN});
+    actions.Apply({4, 0, InputEventKind::MOUSE_DOWN});
+    CHECK(!ActionState::Has(actions.held, ACTION_LEFT) && ActionState::Has(actions.pressed, ACTION_LEFT));
+    CHECK(ActionState::Has(actions.held, ACTION_RIGHT) && ActionState::Has(actions.held, ACTION_PAINT));
+    CHECK(ActionState::Has(actions.changed, ACTION_LEFT) && ActionState::Has(actions.changed, ACTION_JUMP));
+    CHECK(actions.timestamp == 4);
+
+    // Held actions carry over to the next frame, pressed and changed do not
+    actions.BeginFrame();
+    CHECK(ActionState::Has(actions.held, ACTION_RIGHT) && ActionState::Has(actions.held, ACTION_PAINT));
+    CHECK(actions.pressed == 0 && actions.changed == 0);
+    actions.Apply({5, SDLK_SPACE, InputEventKind::KEY_DOWN});
+    actions.Apply({6, 0, InputEventKind::MOUSE_UP});
+    CHECK(ActionState::Has(actions.held, ACTION_JUMP) && !ActionState::Has(actions.held, ACTION_PAINT));
+
+    // Any other key press cancels a pending jump
+    actions.Apply({7, SDLK_d, InputEventKind::KEY_DOWN});
+    CHECK(!ActionState::Has(actions.held, ACTION_JUMP) && ActionState::Has(actions.pressed, ACTION_JUMP));
+
+    std::printf("InputQueueTest passed\n");
+    return 0;
+}
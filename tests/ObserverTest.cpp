@@ -0,0 +1,90 @@
+#include "SceneView.hpp"
+#include "Test.hpp"
+
+int main()
+{
+    Scene scene;
+
+    // Components added before subscribing are not reported
+    std::vector<EntityID> existing;
+    for (int i = 0; i < 10; i++)
+    {
+        EntityID ent = scene.NewEntity();
+        scene.Assign<TransformComponent>(ent);
+        existing.push_back(ent);
+    }
+
+    size_t addCalls = 0;
+    std::vector<EntityID> added;
+    std::vector<EntityID> set;
+    std::vector<EntityID> removed;
+    std::vector<TransformComponent> removedValues;
+    scene.OnAdd<TransformComponent>([&](Scene &observed, const std::vector<EntityID> &entities)
+                                    {
+        addCalls++;
+        for (EntityID ent : entities)
+        {
+            // The batch is dispatched after the component was filled in
+            CHECK(observed.Get<TransformComponent>(ent)->x == float(ent >> 32));
+            added.push_back(ent);
+        } });
+    scene.OnSet<TransformComponent>([&](Scene &, const std::vector<EntityID> &entities)
+                                    { set.insert(set.end(), entities.begin(), entities.end()); });
+    scene.OnRemove<TransformComponent>([&](Scene &, const std::vector<EntityID> &entities, const std::vector<TransformComponent> &values)
+                                       {
+        removed.insert(removed.end(), entities.begin(), entities.end());
+        removedValues.insert(removedValues.end(), values.begin(), values.end()); });
+    scene.FlushCommands();
+    CHECK(added.empty() && set.empty() && removed.empty());
+
+    // Additions are batched until the sync point, one call per batch
+    std::vector<EntityID> entities;
+    for (int i = 0; i < 100; i++)
+    {
+        EntityID ent = scene.NewEntity();
+        scene.Assign<TransformComponent>(ent)->x = float(ent >> 32);
+        entities.push_back(ent);
+    }
+    CHECK(added.empty());
+    scene.FlushCommands();
+    CHECK(addCalls == 1 && added == entities);
+
+    // Writes through GetMut and MarkChanged are reported, plain reads are not, and each batch only once
+    scene.Get<TransformComponent>(existing[0]);
+    scene.GetMut<TransformComponent>(existing[1]);
+    scene.MarkChanged<TransformComponent>(existing[2]);
+    scene.FlushCommands();
+    CHECK(set.size() == 2 && set[0] == existing[1] && set[1] == existing[2]);
+    set.clear();
+    scene.FlushCommands();
+    CHECK(set.empty());
+
+    // Removals are reported with the removed values, from Remove, DestroyEntity and commands alike
+    scene.Remove<TransformComponent>(entities[0]);
+    scene.DestroyEntity(entities[1]);
+    scene.DestroyEntities(&entities[10], 20);
+    scene.GetCommandBuffer().Destroy(entities[50]);
+    CHECK(removed.empty());
+    scene.FlushCommands();
+    CHECK(removed.size() == 23 && removedValues.size() == 23);
+    for (size_t i = 0; i < removed.size(); i++)
+    {
+        CHECK(removedValues[i].x == float(removed[i] >> 32));
+    }
+
+    // Commands recorded by a handler are applied at the next sync point
+    scene.OnAdd<InputComponent>([](Scene &observed, const std::vector<EntityID> &entities)
+                                {
+        for (EntityID ent : entities)
+        {
+            observed.GetCommandBuffer().Destroy(ent);
+        } });
+    scene.Assign<InputComponent>(entities[70]);
+    scene.FlushCommands();
+    CHECK(scene.Get<InputComponent>(entities[70]));
+    scene.FlushCommands();
+    CHECK(!scene.Get<InputComponent>(entities[70]));
+
+    std::printf("ObserverTest passed\n");
+    return 0;
+}
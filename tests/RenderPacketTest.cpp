@@ -0,0 +1,81 @@
+#include "RenderPacket.hpp"
+#include "Test.hpp"
+#include <thread>
+
+// Fill the back packet with commands all tagged with the frame number, then publish it
+static void PublishFrame(FramePackets &packets, uint32_t frame)
+{
+    RenderPacket &packet = packets.Back();
+    packet.Clear();
+    for (uint32_t i = 0; i < 1 + frame % 16; i++)
+    {
+        DrawCommand command;
+        command.firstCell = frame;
+        command.layer = int((frame + i) % 4);
+        packet.commands.push_back(command);
+    }
+    packet.SortByLayer();
+    packets.Publish();
+}
+
+// Frame a packet was published for, checking it was not torn by a later frame
+static uint32_t FrameOf(const RenderPacket &packet)
+{
+    CHECK(!packet.commands.empty());
+    uint32_t frame = packet.commands[0].firstCell;
+    CHECK(packet.commands.size() == 1 + frame % 16);
+    for (size_t i = 0; i < packet.commands.size(); i++)
+    {
+        CHECK(packet.commands[i].firstCell == frame);
+        CHECK(i == 0 || packet.commands[i - 1].layer <= packet.commands[i].layer);
+    }
+    return frame;
+}
+
+int main()
+{
+    // Acquire gets the latest published packet, and keeps it until a newer one is published
+    FramePackets packets;
+    CHECK(packets.Acquire().commands.empty());
+    PublishFrame(packets, 1);
+    CHECK(FrameOf(packets.Acquire()) == 1);
+    CHECK(FrameOf(packets.Acquire()) == 1);
+    PublishFrame(packets, 2);
+    PublishFrame(packets, 3);
+    CHECK(FrameOf(packets.Acquire()) == 3);
+
+    // The producer never writes the packet the consumer holds
+    const RenderPacket *front = &packets.Acquire();
+    for (uint32_t frame = 4; frame < 10; frame++)
+    {
+        CHECK(&packets.Back() != front);
+        PublishFrame(packets, frame);
+    }
+    CHECK(FrameOf(packets.Acquire()) == 9);
+
+    // With both sides on their own threads, packets arrive whole and in order
+    FramePackets shared;
+    const uint32_t frames = 20000;
+    std::thread producer([&shared, frames]
+                         {
+        for (uint32_t frame = 1; frame <= frames; frame++)
+        {
+            PublishFrame(shared, frame);
+        } });
+    uint32_t last = 0;
+    while (last < frames)
+    {
+        const RenderPacket &packet = shared.Acquire();
+        if (packet.commands.empty())
+        {
+            continue;
+        }
+        uint32_t frame = FrameOf(packet);
+        CHECK(frame >= last);
+        last = frame;
+    }
+    producer.join();
+
+    std::printf("RenderPacketTest passed\n");
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include "SceneView.hpp"
+#include "PhysicsThread.hpp"
+#include "Test.hpp"
+#include <thread>
+
+int main()
+{
+    // Enough entities for the pools to span several pages
+    Scene *parent = new Scene();
+    std::vector<EntityID> entities;
+    for (int i = 0; i < 5000; i++)
+    {
+        EntityID ent = parent->NewEntity();
+        entities.push_back(ent);
+        TransformComponent *transform = parent->Assign<TransformComponent>(ent);
+        transform->x = float(i);
+        transform->y = -float(i);
+        if (i % 3 == 0)
+        {
+            SpriteComponent sprite;
+            sprite.filePath = "sprite" + std::to_string(i % 7);
+            parent->AssignShared(ent, sprite);
+        }
+    }
+
+    // Writes in the fork stay in the fork
+    const TransformComponent *kept = parent->Get<TransformComponent>(entities[200]);
+    Scene *fork = parent->Fork();
+
+#ifndef ECS_ARCHETYPE_STORAGE
+    // Reading copies nothing, the fork reads the parent's pages in place until it writes them
+    for (auto [ent, transform] : SceneView<TransformComponent>(*parent).each())
+    {
+        CHECK(fork->Get<TransformComponent>(ent) == &transform);
+    }
+#endif
+    for (size_t i = 0; i < entities.size(); i += 100)
+    {
+        CHECK(fork->Get<TransformComponent>(entities[i])->x == float(i));
+        fork->GetMut<TransformComponent>(entities[i])->x = -1.0f;
+    }
+    for (size_t i = 0; i < entities.size(); i += 100)
+    {
+        CHECK(parent->Get<TransformComponent>(entities[i])->x == float(i));
+        CHECK(fork->Get<TransformComponent>(entities[i])->x == -1.0f);
+        CHECK(fork->Get<TransformComponent>(entities[i]) != parent->Get<TransformComponent>(entities[i]));
+    }
+
+    // The fork copies the pages, so the parent's components stay where they were
+    CHECK(parent->Get<TransformComponent>(entities[200]) == kept);
+    parent->GetMut<TransformComponent>(entities[201])->x = 201.5f;
+    CHECK(parent->Get<TransformComponent>(entities[200]) == kept);
+    CHECK(fork->Get<TransformComponent>(entities[201])->x == 201.0f);
+
+    // Structural changes in the fork do not reach the parent
+    fork->DestroyEntity(entities[3]);
+    fork->Remove<TransformComponent>(entities[6]);
+    EntityID created = fork->NewEntity();
+    fork->Assign<TransformComponent>(created)->x = 123.0f;
+    CHECK(parent->Get<TransformComponent>(entities[6])->x == 6.0f);
+    CHECK(parent->GetShared<SpriteComponent>(entities[3])->filePath == "sprite3");
+    CHECK(!fork->Get<TransformComponent>(entities[3]));
+
+    // Nor do the parent's changes reach the fork
+    parent->DestroyEntity(entities[9]);
+    parent->GetMut<TransformComponent>(entities[12])->x = 999.0f;
+    CHECK(fork->Get<TransformComponent>(entities[12])->x == 12.0f);
+    CHECK(fork->Get<TransformComponent>(entities[9])->x == 9.0f);
+
+    size_t count = 0;
+    for (auto [ent, transform] : SceneView<TransformComponent>(*fork).each())
+    {
+        CHECK(fork->Get<TransformComponent>(ent) == &transform);
+        count++;
+    }
+    CHECK(count == entities.size() - 2 + 1);
+
+    // Threads writing the same shared pages unshare each page once
+    Scene *concurrent = parent->Fork();
+    std::vector<std::thread> writers;
+    for (size_t thread = 0; thread < 4; thread++)
+    {
+        writers.emplace_back([concurrent, &entities, thread]
+                             {
+            for (size_t i = thread; i < entities.size(); i += 4)
+            {
+                if (TransformComponent *transform = concurrent->GetMut<TransformComponent>(entities[i]))
+                {
+                    transform->y = 1.0f;
+                }
+            } });
+    }
+    for (std::thread &writer : writers)
+    {
+        writer.join();
+    }
+    CHECK(concurrent->Get<TransformComponent>(entities[12])->y == 1.0f);
+    CHECK(parent->Get<TransformComponent>(entities[12])->y == -12.0f);
+    delete concurrent;
+
+    // A fork of a fork outlives both scenes it shares pages with
+    Scene *grandchild = fork->Fork();
+    delete parent;
+    delete fork;
+    CHECK(grandchild->Get<TransformComponent>(entities[12])->x == 12.0f);
+    CHECK(grandchild->Get<TransformComponent>(entities[100])->x == -1.0f);
+    CHECK(grandchild->GetShared<SpriteComponent>(entities[0])->filePath == "sprite0");
+    delete grandchild;
+
+    // ForkWithPhysics copies the bodies into a world the fork owns and steps on its own
+    b2World world(b2Vec2(0.0f, 10.0f));
+    PhysicsThread physics(&world);
+    Scene scene;
+    scene.physics = &physics;
+    EntityID body = scene.NewEntity();
+    scene.Assign<TransformComponent>(body);
+    scene.AddBox2DCollider(body, false, false, 1.0f, 1.0f, 1.0f, 1.0f, physics.World());
+    Scene *preview = scene.ForkWithPhysics();
+    CHECK(preview->ownedWorld && preview->ownedWorld->GetBodyCount() == 1);
+    for (int step = 0; step < 30; step++)
+    {
+        preview->StepPhysics(1.0f / 60.0f, 6, 2, 64.0f);
+    }
+    const Box2DColliderComponent *collider = preview->Get<Box2DColliderComponent>(body);
+    CHECK(collider->body->GetWorld() == preview->ownedWorld.get());
+    CHECK(collider->position.y > 1.5f);
+    CHECK(preview->Get<TransformComponent>(body)->y == collider->position.y * 64.0f);
+    CHECK(scene.Get<Box2DColliderComponent>(body)->body->GetPosition().y == 1.0f);
+    delete preview;
+
+    std::printf("SceneForkTest passed\n");
+    return 0;
+}
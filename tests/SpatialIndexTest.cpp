@@ -0,0 +1,141 @@
+#include "SceneView.hpp"
+#include "Test.hpp"
+#include <random>
+#include <set>
+
+// Distance from a point to the bounds of an entity, as the spatial queries measure it
+static float DistanceSquared(const TransformComponent &transform, const BoundsComponent *bounds, float x, float y)
+{
+    float width = bounds ? bounds->width : 0.0f;
+    float height = bounds ? bounds->height : 0.0f;
+    float dx = std::max({transform.x - x, x - (transform.x + width), 0.0f});
+    float dy = std::max({transform.y - y, y - (transform.y + height), 0.0f});
+    return dx * dx + dy * dy;
+}
+
+// Compare every query against a brute force scan of the scene
+static void CheckQueries(Scene &scene, std::mt19937 &rng)
+{
+    std::uniform_real_distribution<float> position(-2000.0f, 2000.0f);
+    std::vector<EntityID> result;
+    for (int query = 0; query < 40; query++)
+    {
+        float x = position(rng);
+        float y = position(rng);
+
+        // Every entity whose box overlaps the query box, each one once
+        float maxX = x + 100.0f * (query % 5);
+        float maxY = y + 150.0f;
+        std::set<EntityID> expected;
+        for (auto [ent, transform, bounds] : SceneView<TransformComponent, Optional<BoundsComponent>>(scene).each())
+        {
+            float width = bounds ? bounds->width : 0.0f;
+            float height = bounds ? bounds->height : 0.0f;
+            if (transform.x <= maxX && transform.x + width >= x && transform.y <= maxY && transform.y + height >= y)
+            {
+                expected.insert(ent);
+            }
+        }
+        scene.spatialIndex.QueryAABB(x, y, maxX, maxY, result);
+        CHECK(std::set<EntityID>(result.begin(), result.end()) == expected);
+        CHECK(result.size() == expected.size());
+
+        // Every entity within the radius
+        float radius = 120.0f;
+        expected.clear();
+        for (auto [ent, transform, bounds] : SceneView<TransformComponent, Optional<BoundsComponent>>(scene).each())
+        {
+            if (DistanceSquared(transform, bounds, x, y) <= radius * radius)
+            {
+                expected.insert(ent);
+            }
+        }
+        scene.spatialIndex.QueryRadius(x, y, radius, result);
+        CHECK(std::set<EntityID>(result.begin(), result.end()) == expected);
+        CHECK(result.size() == expected.size());
+
+        // The k nearest, nearest first: the i-th result is as close as the i-th closest entity
+        size_t k = 1 + query % 8;
+        std::vector<float> distances;
+        for (auto [ent, transform, bounds] : SceneView<TransformComponent, Optional<BoundsComponent>>(scene).each())
+        {
+            distances.push_back(DistanceSquared(transform, bounds, x, y));
+        }
+        std::sort(distances.begin(), distances.end());
+        scene.spatialIndex.QueryNearest(x, y, k, result);
+        CHECK(result.size() == k);
+        for (size_t i = 0; i < k; i++)
+        {
+            CHECK(DistanceSquared(*scene.Get<TransformComponent>(result[i]), scene.Get<BoundsComponent>(result[i]), x, y) == distances[i]);
+        }
+    }
+}
+
+int main()
+{
+    Scene scene;
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> position(-2000.0f, 2000.0f);
+
+    // Points and boxes of various sizes, some spanning several cells
+    std::vector<EntityID> entities;
+    for (int i = 0; i < 3000; i++)
+    {
+        EntityID ent = scene.NewEntity();
+        entities.push_back(ent);
+        TransformComponent *transform = scene.Assign<TransformComponent>(ent);
+        transform->x = position(rng);
+        transform->y = position(rng);
+        if (i % 4 == 0)
+        {
+            BoundsComponent *bounds = scene.Assign<BoundsComponent>(ent);
+            bounds->width = 30.0f + i % 200;
+            bounds->height = 20.0f + i % 90;
+        }
+    }
+    scene.UpdateSpatialIndex();
+    CheckQueries(scene, rng);
+
+    // Pick returns the smallest box containing the point
+    EntityID large = scene.NewEntity();
+    scene.Assign<TransformComponent>(large)->x = 5000.0f;
+    scene.GetMut<TransformComponent>(large)->y = 5000.0f;
+    scene.Assign<BoundsComponent>(large)->width = 300.0f;
+    scene.GetMut<BoundsComponent>(large)->height = 300.0f;
+    EntityID small = scene.NewEntity();
+    scene.Assign<TransformComponent>(small)->x = 5100.0f;
+    scene.GetMut<TransformComponent>(small)->y = 5100.0f;
+    scene.Assign<BoundsComponent>(small)->width = 20.0f;
+    scene.GetMut<BoundsComponent>(small)->height = 20.0f;
+    scene.UpdateSpatialIndex();
+    CHECK(scene.spatialIndex.Pick(5110.0f, 5110.0f) == small);
+    CHECK(scene.spatialIndex.Pick(5010.0f, 5010.0f) == large);
+    CHECK(scene.spatialIndex.Pick(1e7f, 1e7f) == EntityID(-1));
+
+    // Moves, destroyed entities, lost transforms and changed bounds are all picked up by the next update
+    for (size_t i = 0; i < entities.size(); i += 3)
+    {
+        TransformComponent *transform = scene.GetMut<TransformComponent>(entities[i]);
+        transform->x = position(rng);
+        transform->y = position(rng);
+    }
+    for (size_t i = 1; i < entities.size(); i += 7)
+    {
+        scene.DestroyEntity(entities[i]);
+    }
+    for (size_t i = 2; i < entities.size(); i += 11)
+    {
+        scene.Remove<TransformComponent>(entities[i]);
+    }
+    for (size_t i = 0; i < entities.size(); i += 8)
+    {
+        scene.Remove<BoundsComponent>(entities[i]);
+    }
+    scene.GetMut<BoundsComponent>(large)->width = 10.0f;
+    scene.UpdateSpatialIndex();
+    CHECK(scene.spatialIndex.Pick(5200.0f, 5010.0f) == EntityID(-1));
+    CheckQueries(scene, rng);
+
+    std::printf("SpatialIndexTest passed\n");
+    return 0;
+}
@@ -0,0 +1,150 @@
+#include "SystemScheduler.hpp"
+#include "SceneView.hpp"
+#include "Test.hpp"
+#include <chrono>
+
+// Start and end of every system in one global sequence, to tell which systems overlapped
+struct Trace
+{
+    std::atomic<int> clock{0};
+    std::atomic<int> starts[8];
+    std::atomic<int> ends[8];
+
+    std::function<void()> System(int id)
+    {
+        return [this, id]
+        {
+            starts[id] = clock++;
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            ends[id] = clock++;
+        };
+    }
+
+    bool Before(int first, int second) const
+    {
+        return ends[first] < starts[second];
+    }
+};
+
+int main()
+{
+    JobSystem jobs(4);
+    SystemScheduler scheduler(&jobs);
+    Trace trace;
+
+    // Writers of a component run before its later readers and writers, in the order they were added
+    SystemScheduler::SystemHandle writeTransform = scheduler.Add({"WriteTransform", trace.System(0), ComponentMask(), SystemScheduler::Mask<TransformComponent>()});
+    SystemScheduler::SystemHandle writeGrid = scheduler.Add({"WriteGrid", trace.System(1), ComponentMask(), SystemScheduler::Mask<GridSimulationComponent>()});
+    SystemScheduler::SystemHandle readTransform = scheduler.Add({"ReadTransform", trace.System(2), SystemScheduler::Mask<TransformComponent>(), ComponentMask()});
+    SystemScheduler::SystemHandle readInput = scheduler.Add({"ReadInput", trace.System(3), SystemScheduler::Mask<InputComponent>(), ComponentMask()});
+    SystemScheduler::SystemHandle readTransformAgain = scheduler.Add({"ReadTransformAgain", trace.System(4), SystemScheduler::Mask<TransformComponent>(), ComponentMask()});
+    SystemScheduler::SystemHandle writeTransformAgain = scheduler.Add({"WriteTransformAgain", trace.System(5), SystemScheduler::Mask<BoundsComponent>(), SystemScheduler::Mask<TransformComponent>()});
+
+    // Explicit ordering between systems sharing no component
+    scheduler.After(readInput, writeGrid);
+
+    // Main thread systems run on the thread calling Run
+    std::thread::id mainThread = std::this_thread::get_id();
+    std::atomic<bool> ranOnMain{false};
+    scheduler.Add({"Script", [&]
+                   { ranOnMain = std::this_thread::get_id() == mainThread; },
+                   ComponentMask(), ComponentMask(), false, true});
+
+    for (int frame = 0; frame < 3; frame++)
+    {
+        ranOnMain = false;
+        scheduler.Run();
+        CHECK(trace.Before(writeTransform, readTransform));
+        CHECK(trace.Before(writeTransform, readTransformAgain));
+        CHECK(trace.Before(readTransform, writeTransformAgain));
+        CHECK(trace.Before(readTransformAgain, writeTransformAgain));
+        CHECK(trace.Before(readInput, writeGrid));
+        CHECK(ranOnMain);
+    }
+
+    // Start returns at once, Finish runs the main thread systems and waits for the rest
+    ranOnMain = false;
+    scheduler.Start();
+    scheduler.Finish();
+    CHECK(ranOnMain);
+    CHECK(trace.Before(writeTransform, readTransform) && trace.Before(readInput, writeGrid));
+
+    // A serial run keeps a valid order on the calling thread
+    scheduler.Run(true);
+    CHECK(trace.Before(writeTransform, readTransform) && trace.Before(readTransformAgain, writeTransformAgain));
+    CHECK(trace.Before(readInput, writeGrid));
+
+    // An exclusive system runs alone, after the systems added before it and before the ones added after
+    SystemScheduler exclusive(&jobs);
+    Trace exclusiveTrace;
+    exclusive.Add({"Before", exclusiveTrace.System(0), ComponentMask(), ComponentMask()});
+    exclusive.Add({"Alone", exclusiveTrace.System(1), ComponentMask(), ComponentMask(), true});
+    exclusive.Add({"After", exclusiveTrace.System(2), ComponentMask(), ComponentMask()});
+    exclusive.Run();
+    CHECK(exclusiveTrace.Before(0, 1) && exclusiveTrace.Before(1, 2));
+
+    // A constraint cycle must not hang, every system still runs once
+    SystemScheduler cycle(&jobs);
+    std::atomic<int> runs{0};
+    SystemScheduler::SystemHandle first = cycle.Add({"First", [&]
+                                                     { runs++; },
+                                                     ComponentMask(), ComponentMask()});
+    SystemScheduler::SystemHandle second = cycle.Add({"Second", [&]
+                                                      { runs++; },
+                                                      ComponentMask(), ComponentMask()});
+    cycle.After(first, second);
+    cycle.After(second, first);
+    cycle.Run();
+    CHECK(runs == 2);
+
+    // Running serially keeps the parallel loops of the systems on the main thread too
+    Scene scene;
+    scene.jobSystem = &jobs;
+    scene.m_serialSystems = true;
+    for (int i = 0; i < 1000; i++)
+    {
+        scene.Assign<TransformComponent>(scene.NewEntity());
+    }
+    SystemScheduler serial(&jobs);
+    std::atomic<int> offMain{0};
+    auto onMain = [&](EntityID, const TransformComponent &)
+    {
+        offMain += std::this_thread::get_id() != mainThread;
+    };
+    serial.Add({"View", [&]
+                { SceneView<TransformComponent>(scene).par_each(onMain, 64); },
+                SystemScheduler::Mask<TransformComponent>(), ComponentMask()});
+    serial.Add({"Group", [&]
+                { Group<TransformComponent>(scene).par_each(onMain, 64); },
+                SystemScheduler::Mask<TransformComponent>(), ComponentMask()});
+    serial.Run(scene.m_serialSystems);
+    CHECK(offMain == 0);
+
+    // Parallel loops visit every matching entity once, whichever order they cut the storage in
+    scene.m_serialSystems = false;
+    int assigned = 0;
+    for (EntityID ent : SceneView<TransformComponent>(scene))
+    {
+        if (assigned++ % 3 == 0)
+        {
+            scene.Assign<InputComponent>(ent);
+        }
+    }
+    for (int grain : {1, 64, 300})
+    {
+        std::vector<std::atomic<int>> visits(1000);
+        SceneView<Mut<TransformComponent>, Without<InputComponent>>(scene).par_each([&](EntityID ent, TransformComponent &)
+                                                                                   { visits[scene.GetEntityIndex(ent)]++; },
+                                                                                   grain);
+        SceneView<TransformComponent, Mut<InputComponent>>(scene).par_each([&](EntityID ent, const TransformComponent &, InputComponent &)
+                                                                          { visits[scene.GetEntityIndex(ent)]++; },
+                                                                          grain);
+        for (int i = 0; i < 1000; i++)
+        {
+            CHECK(visits[i] == 1);
+        }
+    }
+
+    std::printf("SystemSchedulerTest passed\n");
+    return 0;
+}